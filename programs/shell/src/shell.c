@@ -8,10 +8,7 @@ int main(int argc, char** argv)
     while(1)
     {
         print(argv[0]);
-        for (int i = 0; i < 1000000; i++)
-        {
-            
-        }
+        maeros_sleep(500);
     }
     // while(1) 
     // {
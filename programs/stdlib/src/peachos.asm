@@ -2,109 +2,126 @@
 
 section .asm
 
-global print:function ; print is a function label
-global peachos_getkey:function
-global maeros_malloc:function
-global maeros_free:function
-global maeros_putchar:function
-global maeros_process_load_start:function
-global maeros_process_get_arguments:function 
-global maeros_system:function
-global maeros_exit:function
+global maeros_syscall_init:function
+global maeros_syscall:function
+global maeros_rdtsc:function
+global maeros_thread_start:function
+global maeros_thread_area:function
+global maeros_dl_resolve:function
 
-; void print(const char* message)
-print:
-    push ebp ; push base pointer
-    mov ebp, esp
-    push dword[ebp+8]   ; 8 because we pushed twice previously (ebp and return address)
-                        ; thats how we pushed message to stack
-    mov eax, 1 ; syscall to Command print
-    int 0x80
-    add esp, 4 ; add 4 because we push message (4 bytes) and it should be restored back
-    pop ebp ; pop base pointer
-    ret
+extern maeros_thread_exit
+extern maeros_dl_bind
+extern _GLOBAL_OFFSET_TABLE_
 
-; int peachos_getkey() //get key from user via terminal
-peachos_getkey:
-    push ebp
-    mov ebp, esp
-    mov eax, 2 ; Command getkey
-    int 0x80
-    pop ebp
-    ret
+; the library is shared and position independent, so the code does not refer to an absolute
+; address. It finds the GOT of the library relative to itself and reads the address of
+; the data from it, i.e. "get_got ebx" then "mov eax, [ebx + symbol wrt ..got]"
+%macro get_got 1
+    call %%here
+%%here:
+    pop %1
+    add %1, _GLOBAL_OFFSET_TABLE_ + $$ - %%here wrt ..gotpc
+%endmacro
 
-; void maeros_putchar(char c)
-maeros_putchar:
-    push ebp
-    mov ebp, esp
-    mov eax, 3 ; Command putchar
-    push dword [ebp+8] ; Variable "c"
-    int 0x80
-    add esp, 4
-    pop ebp
+; void maeros_syscall_init()
+; CPUID leaf 1 sets bit 11 (SEP) of edx when SYSENTER/SYSEXIT are there
+maeros_syscall_init:
+    push ebx
+    mov eax, 1
+    cpuid
+    xor eax, eax
+    bt edx, 11
+    setc al
+    get_got ebx
+    mov ecx, [ebx + maeros_fast_syscalls wrt ..got]
+    mov [ecx], eax
+    pop ebx
     ret
 
-; void* maeros_malloc(size_t size)
-maeros_malloc:
+; unsigned int maeros_syscall(int command, unsigned int arg0, ..., unsigned int arg4)
+; the stubs of the syscall table (see peachos.c) come here with every argument.
+; The command is in eax and the arguments in ebx, ecx, edx, esi and edi. SYSENTER is
+; used when the CPU has it, it takes the stack pointer in ecx and the return address in
+; edx, so the arguments in those two go onto the stack where the kernel picks them up.
+; Otherwise we take the int 0x80 fallback. ecx and edx are overwritten, they do not have
+; to be kept by a C function.
+maeros_syscall:
     push ebp
     mov ebp, esp
-    mov eax, 4 ; Command 4 malloc (Allocates memory for the process)
-    push dword[ebp+8] ; Variable "size"
+    push ebx
+    push esi
+    push edi
+    get_got ebx
+    mov eax, [ebx + maeros_fast_syscalls wrt ..got]
+    cmp dword [eax], 0
+    mov eax, [ebp+8] ; Variable "command"
+    mov ebx, [ebp+12] ; Variable "arg0"
+    mov ecx, [ebp+16] ; Variable "arg1"
+    mov edx, [ebp+20] ; Variable "arg2"
+    mov esi, [ebp+24] ; Variable "arg3"
+    mov edi, [ebp+28] ; Variable "arg4"
+    je .trap
+    push edx
+    push ecx
+    ; the return address relative to where we are
+    call .here
+.here:
+    pop edx
+    add edx, .return - .here
+    mov ecx, esp
+    sysenter
+.return:
+    add esp, 8
+    jmp .done
+.trap:
     int 0x80
-    add esp, 4
+.done:
+    pop edi
+    pop esi
+    pop ebx
     pop ebp
     ret
 
-; void maeros_free(void* ptr)
-maeros_free:
-    push ebp
-    mov ebp, esp
-    mov eax, 5 ; Command 5 free (Frees the allocated memory for this process)
-    push dword[ebp+8] ; Variable "ptr"
-    int 0x80
-    add esp, 4
-    pop ebp
+; uint64_t maeros_rdtsc()
+maeros_rdtsc:
+    rdtsc
     ret
 
-; void maeros_process_load_start(const char* filename)
-maeros_process_load_start:
-    push ebp
-    mov ebp, esp
-    mov eax, 6 ; Command 6 process load start ( stars a process )
-    push dword[ebp+8] ; Variable "filename"
-    int 0x80
-    add esp, 4  ;in contrary to other commands, we do not back from int80h
-    pop ebp
-    ret
+; the first code of a new thread, the kernel puts the function and its argument onto the stack
+maeros_thread_start:
+    pop eax ; function, the argument is on top of the stack now
+    call eax
+    push eax ; the return value is the exit code
+    call maeros_thread_exit
+    ; we never come back here
 
-; int maeros_system(struct command_argument* arguments)
-maeros_system:
-    push ebp
-    mov ebp, esp
-    mov eax, 7 ; Command 7 process_system ( runs a system command based on the arguments)
-    push dword[ebp+8] ; Variable "arguments"
-    int 0x80
-    add esp, 4
-    pop ebp
+; void* maeros_thread_area()
+maeros_thread_area:
+    mov eax, [gs:0] ; the first word of the area points at the area itself
     ret
 
+; the lazy binding of a function the program calls through its PLT for the first time (see
+; src/loader/formats/elflink.h), the PLT pushed the index of the file and the relocation
+; offset. The kernel writes the address of the function to the GOT entry and returns it,
+; we jump to the function as if it had been called directly.
+maeros_dl_resolve:
+    push eax
+    push ecx
+    push edx
+    push dword [esp+16] ; the relocation offset
+    push dword [esp+16] ; the index of the file
+    call maeros_dl_bind
+    add esp, 8
+    mov [esp+16], eax ; the function takes the place of the relocation offset
+    pop edx
+    pop ecx
+    pop eax
+    add esp, 4 ; the index of the file
+    ret ; to the function, it returns to the caller of the PLT entry
 
-; void maeros_process_get_arguments(struct process_arguments* arguments)
-maeros_process_get_arguments:
-    push ebp
-    mov ebp, esp
-    mov eax, 8 ; Command 8 Gets the process arguments
-    push dword[ebp+8] ; Variable arguments
-    int 0x80
-    add esp, 4
-    pop ebp
-    ret
+section .data
 
-; void maeros_exit()
-maeros_exit:
-    push ebp
-    mov ebp, esp
-    mov eax, 9 ; Command 9 process exit
-    int 0x80
-    pop ebp
-    ret
\ No newline at end of file
+global maeros_fast_syscalls
+
+; non zero when system calls go through SYSENTER, see maeros_syscall_init
+maeros_fast_syscalls: dd 0
@@ -1,5 +1,34 @@
 #include "peachos.h"
 #include "string.h"
+#include "div64.h"
+
+#define MAEROS_SYSCALL_PARAMETERS_0(...)
+#define MAEROS_SYSCALL_PARAMETERS_1(t0) t0 a0
+#define MAEROS_SYSCALL_PARAMETERS_2(t0, t1) t0 a0, t1 a1
+#define MAEROS_SYSCALL_PARAMETERS_3(t0, t1, t2) t0 a0, t1 a1, t2 a2
+#define MAEROS_SYSCALL_PARAMETERS_4(t0, t1, t2, t3) t0 a0, t1 a1, t2 a2, t3 a3
+#define MAEROS_SYSCALL_PARAMETERS_5(t0, t1, t2, t3, t4) t0 a0, t1 a1, t2 a2, t3 a3, t4 a4
+
+/** @brief the argument registers of maeros_syscall, the unused ones are zero */
+#define MAEROS_SYSCALL_REGISTERS_0 0, 0, 0, 0, 0
+#define MAEROS_SYSCALL_REGISTERS_1 (unsigned int) a0, 0, 0, 0, 0
+#define MAEROS_SYSCALL_REGISTERS_2 (unsigned int) a0, (unsigned int) a1, 0, 0, 0
+#define MAEROS_SYSCALL_REGISTERS_3 (unsigned int) a0, (unsigned int) a1, (unsigned int) a2, 0, 0
+#define MAEROS_SYSCALL_REGISTERS_4 (unsigned int) a0, (unsigned int) a1, (unsigned int) a2, (unsigned int) a3, 0
+#define MAEROS_SYSCALL_REGISTERS_5 (unsigned int) a0, (unsigned int) a1, (unsigned int) a2, (unsigned int) a3, (unsigned int) a4
+
+#define MAEROS_SYSCALL_STUB(command, handler, stub, type, count, types)                               \
+    type stub(MAEROS_SYSCALL_APPLY(MAEROS_SYSCALL_PARAMETERS_##count, MAEROS_SYSCALL_EXPAND types))     \
+    {                                                                                                 \
+        return (type) maeros_syscall(command, MAEROS_SYSCALL_REGISTERS_##count);                      \
+    }
+
+MAEROS_SYSCALLS(MAEROS_SYSCALL_STUB)
+
+int maeros_thread_create(int (*function)(void* arg), void* arg)
+{
+    return maeros_thread_create_at(maeros_thread_start, function, arg);
+}
 
 /** @brief parse commands by using blank space aws delimiter */
 struct command_argument* peachos_parse_command(const char* command, int max)
@@ -48,17 +77,6 @@ struct command_argument* peachos_parse_command(const char* command, int max)
 out:
     return root_command;
 }
-int peachos_getkeyblock()
-{
-    int val = 0;
-    do
-    {
-        val = peachos_getkey();
-    }
-    while(val == 0);
-    return val;
-}
-
 void peachos_terminal_readline(char* out, int max, bool output_while_typing)
 {
     int i = 0;
@@ -104,4 +122,66 @@ int maeros_system_run(const char* command)
     }
 
     return maeros_system(root_command_argument);
-}
\ No newline at end of file
+}
+
+bool maeros_ring_submit(struct maeros_ring* ring, int command, int arg0, int arg1, int arg2, int user_data)
+{
+    unsigned int tail = ring->submission_tail;
+    if (tail - ring->submission_head >= MAEROS_RING_ENTRIES)
+    {
+        return false;
+    }
+
+    // volatile keeps the compiler from moving the stores below the one to the tail
+    volatile struct maeros_ring_submission* submission = &ring->submissions[tail % MAEROS_RING_ENTRIES];
+    submission->command = command;
+    submission->arguments[0] = arg0;
+    submission->arguments[1] = arg1;
+    submission->arguments[2] = arg2;
+    submission->user_data = user_data;
+
+    // The kernel sees the entry once the tail moves past it
+    ring->submission_tail = tail + 1;
+    return true;
+}
+
+bool maeros_ring_complete(struct maeros_ring* ring, struct maeros_ring_completion* completion)
+{
+    unsigned int head = ring->completion_head;
+    if (head == ring->completion_tail)
+    {
+        return false;
+    }
+
+    *completion = ring->completions[head % MAEROS_RING_ENTRIES];
+    ring->completion_head = head + 1;
+    return true;
+}
+
+/** @brief the data page of the process */
+static volatile struct maeros_vdso* const maeros_vdso = (volatile struct maeros_vdso*) MAEROS_VDSO_ADDRESS;
+
+unsigned long long maeros_div64(unsigned long long dividend, unsigned int divisor)
+{
+    return div64(dividend, divisor);
+}
+
+int maeros_getpid()
+{
+    return maeros_vdso->pid;
+}
+
+int maeros_getcpu()
+{
+    return maeros_vdso->cpu;
+}
+
+unsigned int maeros_uptime_ms()
+{
+    return (unsigned int) maeros_div64(maeros_rdtsc() - maeros_vdso->tsc_boot, maeros_vdso->tsc_per_ms);
+}
+
+unsigned int maeros_ticks()
+{
+    return (unsigned int) maeros_div64(maeros_rdtsc() - maeros_vdso->tsc_boot, maeros_vdso->tsc_per_tick);
+}
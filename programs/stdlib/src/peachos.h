@@ -2,6 +2,7 @@
 #define PEACHOS_H
 #include <stddef.h>
 #include <stdbool.h>
+#include "syscalls.h"
 
 /** @brief command argument list that is written to shell
  * i.e. echo text -> echo is the first argument and test is the second argument
@@ -12,34 +13,138 @@ struct command_argument
     struct command_argument* next;
 };
 
+/** @brief number of entries of each syscall ring, see maeros_ring_setup */
+#define MAEROS_RING_ENTRIES 64
+/** @brief the kernel runs the queued syscalls from the timer interrupt as well */
+#define MAEROS_RING_DRAIN_ON_TICK 0x01
+
+/** @brief a syscall queued in the submission ring, the arguments are in the syscall order */
+struct maeros_ring_submission
+{
+    unsigned int command;
+    unsigned int arguments[5];
+    unsigned int user_data;
+};
+
+struct maeros_ring_completion
+{
+    unsigned int user_data;
+    int result;
+};
+
+/** @brief the page shared with the kernel, the program writes submission_tail and completion_head */
+struct maeros_ring
+{
+    volatile unsigned int submission_head;
+    volatile unsigned int submission_tail;
+    volatile unsigned int completion_head;
+    volatile unsigned int completion_tail;
+
+    struct maeros_ring_submission submissions[MAEROS_RING_ENTRIES];
+    struct maeros_ring_completion completions[MAEROS_RING_ENTRIES];
+};
+
+/** @brief where the kernel maps the read-only data page of the process, it is
+ * MAEROS_VDSO_VIRTUAL_ADDRESS of the kernel's config.h */
+#define MAEROS_VDSO_ADDRESS 0x3FF000
+
+/** @brief the data page, it is the kernel's struct vdso_data */
+struct maeros_vdso
+{
+    unsigned int pid;
+    unsigned int cpu;
+    unsigned int cpu_count;
+    unsigned int ticks;
+    unsigned int timer_hz;
+    unsigned int tsc_per_ms;
+    unsigned int tsc_per_tick;
+    unsigned long long tsc_boot;
+};
+
+/** @brief number of latency histogram buckets, bucket i counts the calls taking less than
+ * 2^(MAEROS_STATS_FIRST_BUCKET_BITS + i) cycles, the last one counts the longer calls too */
+#define MAEROS_STATS_BUCKETS 16
+#define MAEROS_STATS_FIRST_BUCKET_BITS 7
+/** @brief process id of maeros_syscall_stats to get the totals of all processes */
+#define MAEROS_STATS_ALL_PROCESSES -1
+
+/** @brief call count and latency of a syscall, it is the kernel's struct isr80h_command_stats */
+struct maeros_syscall_stats
+{
+    unsigned int calls;
+    unsigned int max_cycles;
+    unsigned long long total_cycles;
+    unsigned int histogram[MAEROS_STATS_BUCKETS];
+};
+
 struct process_arguments
 {
     int argc;
     char** argv;
 };
 
-/** @brief print function implemented in stdlib 
- * notice that this also call syscal 1 to print to screen 
+/** @brief non zero when system calls enter the kernel with SYSENTER rather than int 0x80.
+ * It is set at start up if the CPU supports SYSENTER, a program may clear it to use int 0x80.
 */
-void print(const char* filename);
+extern int maeros_fast_syscalls;
+
+/** @brief a stub of each row of the syscall table (see syscalls.h), a pointer to a structure
+ * is a void* there. Among them:
+ *  - maeros_sum(v1, v2) sums two numbers in the kernel, the cheapest system call there is
+ *  - maeros_thread_join(thread_id, exit_code) waits until the thread stops, its exit code is
+ *    written to 'exit_code' unless it is null
+ *  - maeros_set_thread_area(area) makes gs of the calling thread point at 'area', the first
+ *    word of the area must point at the area itself
+ *  - maeros_ring_setup(flags) maps the syscall rings of the process, 'flags' is
+ *    MAEROS_RING_DRAIN_ON_TICK or zero, and maeros_ring_enter(count) runs up to 'count'
+ *    queued syscalls in a single trap
+ *  - maeros_syscall_stats(process_id, command, stats) reads the call count and latency of a
+ *    syscall of a process, or of all of them with MAEROS_STATS_ALL_PROCESSES
+ *  - maeros_dl_bind(index, offset) binds a function of the stdlib a program calls for the
+ *    first time, only maeros_dl_resolve calls it (see src/loader/formats/elflink.h)
+*/
+#define MAEROS_SYSCALL_DECLARE(command, handler, stub, type, count, types) type stub types;
+MAEROS_SYSCALLS(MAEROS_SYSCALL_DECLARE)
+
+/** @brief enter the kernel for 'command' with all five argument registers, the stubs use it */
+unsigned int maeros_syscall(int command, unsigned int arg0, unsigned int arg1, unsigned int arg2, unsigned int arg3, unsigned int arg4);
 
-/** @brief get pressed key by user implemented in standad library */
-int peachos_getkey();
+/** @brief read the time stamp counter of the CPU */
+unsigned long long maeros_rdtsc();
+
+/** @brief the process id, read from the data page without a syscall */
+int maeros_getpid();
+/** @brief the CPU a thread of the process last returned to user land on */
+int maeros_getcpu();
+/** @brief milliseconds since boot, computed from the TSC without a syscall */
+unsigned int maeros_uptime_ms();
+/** @brief timer ticks since boot, computed from the TSC without a syscall */
+unsigned int maeros_ticks();
+/** @brief divide a 64 bit number by a 32 bit number, there is no libgcc for the '/' operator */
+unsigned long long maeros_div64(unsigned long long dividend, unsigned int divisor);
 
-/** @brief the function calls malloc syscall function */
-void* maeros_malloc(size_t size);
-void maeros_free(void* ptr);
-/** @brief stdlib put char to terminal */
-void maeros_putchar(char c);
-int peachos_getkeyblock();
 void peachos_terminal_readline(char* out, int max, bool output_while_typing);
 
-/** @brief the routine call syscall to load user process */
-void maeros_process_load_start(const char* filename);
 struct command_argument* peachos_parse_command(const char* command, int max);
-/** @brief Asm routine to get process arguments */
-void maeros_process_get_arguments(struct process_arguments* arguments);
-int maeros_system(struct command_argument* arguments);
 int maeros_system_run(const char* command);
-void maeros_exit();
+
+/** @brief start a thread running 'function(arg)' in this process, it shares the memory of the
+ * process but it has a stack of its own. The thread exits with the return value of 'function'.
+ * @retval the thread id, or a negative error code
+*/
+int maeros_thread_create(int (*function)(void* arg), void* arg);
+/** @brief the first code of a thread started by maeros_thread_create, it is in peachos.asm */
+void maeros_thread_start();
+
+/** @brief the thread area of the calling thread, read through gs without a syscall */
+void* maeros_thread_area();
+
+/** @brief queue syscall 'command' with up to three arguments
+ * @retval false if the submission ring is full
+*/
+bool maeros_ring_submit(struct maeros_ring* ring, int command, int arg0, int arg1, int arg2, int user_data);
+/** @brief take the next result out of the completion ring
+ * @retval false if there is none
+*/
+bool maeros_ring_complete(struct maeros_ring* ring, struct maeros_ring_completion* completion);
 #endif
\ No newline at end of file
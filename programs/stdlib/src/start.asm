@@ -2,11 +2,14 @@
 
 global _start
 extern c_start
+extern maeros_syscall_init
 extern maeros_exit
 
 section .asm
 
 _start:
+; pick the system call path before anything calls the kernel
+    call maeros_syscall_init
 ; it starts main program
     call c_start
     ;if program returns(not running forever), then exis from a program
@@ -0,0 +1,41 @@
+#include "peachos.h"
+#include "stdio.h"
+
+/** @file sysbench.c
+ * @brief syscall latency microbenchmark, it compares the SYSENTER path with int 0x80
+*/
+
+/** @brief number of system calls timed for each path */
+#define SYSBENCH_ITERATIONS 10000
+
+/** @brief average TSC cycles of a round trip to the kernel through the selected path */
+static unsigned int sysbench_measure()
+{
+    unsigned long long start = maeros_rdtsc();
+    for (int i = 0; i < SYSBENCH_ITERATIONS; i++)
+    {
+        maeros_sum(i, 1);
+    }
+
+    // A run takes well below 2^32 cycles, there is no 64 bit division without libgcc
+    unsigned int cycles = (unsigned int)(maeros_rdtsc() - start);
+    return cycles / SYSBENCH_ITERATIONS;
+}
+
+int main(int argc, char** argv)
+{
+    int fast_syscalls = maeros_fast_syscalls;
+
+    maeros_fast_syscalls = 0;
+    printf("int 0x80: %i cycles per syscall\n", sysbench_measure());
+
+    if (!fast_syscalls)
+    {
+        printf("sysenter: not supported by the CPU\n");
+        return 0;
+    }
+
+    maeros_fast_syscalls = 1;
+    printf("sysenter: %i cycles per syscall\n", sysbench_measure());
+    return 0;
+}
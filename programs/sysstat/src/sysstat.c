@@ -0,0 +1,76 @@
+#include "peachos.h"
+#include "stdio.h"
+#include "string.h"
+
+/** @file sysstat.c
+ * @brief print the call count and latency of every syscall, of all processes or of the
+ * process whose id is given as the argument, i.e. "sysstat 2"
+*/
+
+#define SYSSTAT_NAME(command, handler, stub, type, count, types) [command] = #stub,
+
+/** @brief syscall names by command number, a syscall is named after its stub */
+static const char* sysstat_names[SYSTEM_COMMANDS_TOTAL] = {
+    MAEROS_SYSCALLS(SYSSTAT_NAME)
+};
+
+static int sysstat_parse_number(const char* str)
+{
+    int number = 0;
+    while (isdigit(*str))
+    {
+        number = number * 10 + tonumericdigit(*str);
+        str++;
+    }
+
+    return number;
+}
+
+static void sysstat_print(int command, struct maeros_syscall_stats* stats)
+{
+    unsigned int average = (unsigned int) maeros_div64(stats->total_cycles, stats->calls);
+    printf("%s: %i calls, avg %i max %i cycles\n", sysstat_names[command], stats->calls, average, stats->max_cycles);
+
+    // Only the buckets with calls in them, each one is labelled with its upper bound
+    for (int i = 0; i < MAEROS_STATS_BUCKETS; i++)
+    {
+        if (!stats->histogram[i])
+        {
+            continue;
+        }
+
+        if (i == MAEROS_STATS_BUCKETS - 1)
+        {
+            printf("  longer: %i\n", stats->histogram[i]);
+            continue;
+        }
+        printf("  <%i: %i\n", 1 << (MAEROS_STATS_FIRST_BUCKET_BITS + i), stats->histogram[i]);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int process_id = MAEROS_STATS_ALL_PROCESSES;
+    if (argc > 1)
+    {
+        process_id = sysstat_parse_number(argv[1]);
+    }
+
+    struct maeros_syscall_stats stats;
+    for (int command = 0; command < SYSTEM_COMMANDS_TOTAL; command++)
+    {
+        int res = maeros_syscall_stats(process_id, command, &stats);
+        if (res < 0)
+        {
+            printf("sysstat: no stats, the kernel is built without them or the process does not exist\n");
+            return res;
+        }
+
+        if (stats.calls)
+        {
+            sysstat_print(command, &stats);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include "ioapic.h"
+#include "lapic.h"
+
+static void ioapic_mask(int irq);
+static void ioapic_unmask(int irq);
+static void ioapic_eoi(int irq);
+
+static struct irq_chip ioapic_chip = {
+    .name = "IOAPIC",
+    .mask = ioapic_mask,
+    .unmask = ioapic_unmask,
+    .eoi = ioapic_eoi
+};
+
+/** @brief the registers of the IOAPIC, zero if there is none */
+static volatile uint32_t* ioapic_registers = 0;
+
+/** @brief the redirection entry index of each ISA IRQ, -1 if the IRQ is not connected */
+static int ioapic_irq_input[IRQ_TOTAL];
+
+static uint32_t ioapic_read(uint32_t reg)
+{
+    ioapic_registers[IOAPIC_REG_SELECT / sizeof(uint32_t)] = reg;
+    return ioapic_registers[IOAPIC_REG_WINDOW / sizeof(uint32_t)];
+}
+
+static void ioapic_write(uint32_t reg, uint32_t value)
+{
+    ioapic_registers[IOAPIC_REG_SELECT / sizeof(uint32_t)] = reg;
+    ioapic_registers[IOAPIC_REG_WINDOW / sizeof(uint32_t)] = value;
+}
+
+int ioapic_total_inputs()
+{
+    if (!ioapic_registers)
+    {
+        return 0;
+    }
+
+    // Bits 16-23 of the version register hold the index of the last entry
+    return ((ioapic_read(IOAPIC_REG_VERSION) >> 16) & 0xFF) + 1;
+}
+
+static void ioapic_mask(int irq)
+{
+    if (ioapic_irq_input[irq] < 0)
+    {
+        return;
+    }
+
+    uint32_t reg = IOAPIC_REG_REDIRECTION + ioapic_irq_input[irq] * 2;
+    ioapic_write(reg, ioapic_read(reg) | IOAPIC_REDIRECTION_MASKED);
+}
+
+static void ioapic_unmask(int irq)
+{
+    if (ioapic_irq_input[irq] < 0)
+    {
+        return;
+    }
+
+    uint32_t reg = IOAPIC_REG_REDIRECTION + ioapic_irq_input[irq] * 2;
+    ioapic_write(reg, ioapic_read(reg) & ~IOAPIC_REDIRECTION_MASKED);
+}
+
+/** @brief whether the input of the IRQ is taken by another IRQ, i.e. IRQ 0 is moved to
+ * input 2 which would be IRQ 2 (the PIC cascade) otherwise */
+static bool ioapic_input_overridden(struct madt_info* info, int irq)
+{
+    if (info->irq_gsi[irq] != irq)
+    {
+        return false;
+    }
+
+    for (int other = 0; other < IRQ_TOTAL; other++)
+    {
+        if (other != irq && info->irq_gsi[other] == info->irq_gsi[irq])
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void ioapic_eoi(int irq)
+{
+    // The local APIC that took the interrupt tells the IOAPIC (for level triggered ones)
+    lapic_eoi();
+}
+
+struct irq_chip* ioapic_init(struct madt_info* info, uint8_t apic_id)
+{
+    ioapic_registers = (volatile uint32_t*) info->ioapic_address;
+
+    int total = ioapic_total_inputs();
+    for (int i = 0; i < total; i++)
+    {
+        ioapic_write(IOAPIC_REG_REDIRECTION + i * 2, IOAPIC_REDIRECTION_MASKED);
+        ioapic_write(IOAPIC_REG_REDIRECTION + i * 2 + 1, 0);
+    }
+
+    for (int irq = 0; irq < IRQ_TOTAL; irq++)
+    {
+        int input = info->irq_gsi[irq] - info->ioapic_gsi_base;
+        if (input < 0 || input >= total || ioapic_input_overridden(info, irq))
+        {
+            ioapic_irq_input[irq] = -1;
+            continue;
+        }
+        ioapic_irq_input[irq] = input;
+
+        uint32_t entry = IOAPIC_REDIRECTION_MASKED | (IRQ_VECTOR_BASE + irq);
+        if ((info->irq_flags[irq] & MADT_FLAGS_POLARITY_MASK) == MADT_FLAGS_POLARITY_LOW)
+        {
+            entry |= IOAPIC_REDIRECTION_ACTIVE_LOW;
+        }
+        if ((info->irq_flags[irq] & MADT_FLAGS_TRIGGER_MASK) == MADT_FLAGS_TRIGGER_LEVEL)
+        {
+            entry |= IOAPIC_REDIRECTION_LEVEL;
+        }
+
+        // Physical destination mode, the IRQ goes to one CPU
+        ioapic_write(IOAPIC_REG_REDIRECTION + input * 2 + 1, (uint32_t) apic_id << 24);
+        ioapic_write(IOAPIC_REG_REDIRECTION + input * 2, entry);
+    }
+
+    return &ioapic_chip;
+}
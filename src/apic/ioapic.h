@@ -0,0 +1,39 @@
+#ifndef IOAPIC_H
+#define IOAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "irq/irq.h"
+#include "madt.h"
+
+/** @file ioapic.h
+ * @brief The IOAPIC routes the device interrupts to the local APICs. Its registers are
+ * accessed indirectly, the register number is written to IOREGSEL and the value is read or
+ * written through IOWIN. Each input has a 64 bit redirection entry giving the vector and the
+ * destination CPU of the interrupt.
+*/
+
+#define IOAPIC_REG_SELECT 0x00
+#define IOAPIC_REG_WINDOW 0x10
+
+#define IOAPIC_REG_ID 0x00
+#define IOAPIC_REG_VERSION 0x01
+/** @brief each redirection entry is two registers (64 bits) starting at 0x10 */
+#define IOAPIC_REG_REDIRECTION 0x10
+
+/** @brief redirection entry bits */
+#define IOAPIC_REDIRECTION_ACTIVE_LOW 0x2000
+#define IOAPIC_REDIRECTION_LEVEL 0x8000
+#define IOAPIC_REDIRECTION_MASKED 0x10000
+
+/** @brief set where the registers are mapped and route every ISA IRQ, masked, to vector
+ * IRQ_VECTOR_BASE + irq on the CPU 'apic_id'. The IRQs are routed through the override
+ * entries of the MADT.
+*/
+struct irq_chip* ioapic_init(struct madt_info* info, uint8_t apic_id);
+
+/** @brief number of interrupt inputs of the IOAPIC */
+int ioapic_total_inputs();
+
+#endif
@@ -0,0 +1,136 @@
+#include "lapic.h"
+#include "timer/clock.h"
+#include "timer/div64.h"
+
+/** @brief the registers of the local APIC, zero until lapic_init */
+static volatile uint32_t* lapic_registers = 0;
+
+/** @brief timer ticks per millisecond (divided by 16) */
+static uint32_t lapic_timer_ticks = 0;
+
+static uint64_t lapic_timer_max_cycles();
+
+static struct clock_event lapic_event = {
+    .name = "LAPIC timer",
+    .max_cycles = lapic_timer_max_cycles,
+    .program = lapic_timer_program,
+    .stop = lapic_timer_stop
+};
+
+static uint32_t lapic_read(uint32_t reg)
+{
+    return lapic_registers[reg / sizeof(uint32_t)];
+}
+
+static void lapic_write(uint32_t reg, uint32_t value)
+{
+    lapic_registers[reg / sizeof(uint32_t)] = value;
+}
+
+void lapic_init(uint32_t address)
+{
+    lapic_registers = (volatile uint32_t*) address;
+}
+
+bool lapic_available()
+{
+    return lapic_registers != 0;
+}
+
+void lapic_enable(bool bsp, bool extint)
+{
+    // Accept all the interrupts
+    lapic_write(LAPIC_REG_TPR, 0);
+
+    lapic_write(LAPIC_REG_LVT_LINT0, extint ? LAPIC_LVT_EXTINT : LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_LVT_LINT1, bsp ? LAPIC_LVT_NMI : LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_LVT_ERROR, LAPIC_LVT_MASKED);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR);
+
+    lapic_write(LAPIC_REG_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_VECTOR);
+}
+
+uint8_t lapic_id()
+{
+    return lapic_read(LAPIC_REG_ID) >> 24;
+}
+
+void lapic_eoi()
+{
+    lapic_write(LAPIC_REG_EOI, 0);
+}
+
+/** @brief write the interrupt command and wait until the local APIC sent it */
+static void lapic_send(uint8_t apic_id, uint32_t command)
+{
+    lapic_write(LAPIC_REG_ICR_HIGH, (uint32_t) apic_id << 24);
+    lapic_write(LAPIC_REG_ICR_LOW, command);
+    while(lapic_read(LAPIC_REG_ICR_LOW) & LAPIC_ICR_DELIVERY_PENDING)
+    {
+    }
+}
+
+void lapic_send_init(uint8_t apic_id)
+{
+    lapic_send(apic_id, LAPIC_ICR_INIT);
+}
+
+void lapic_send_startup(uint8_t apic_id, uint8_t vector)
+{
+    lapic_send(apic_id, LAPIC_ICR_STARTUP | vector);
+}
+
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector)
+{
+    lapic_send(apic_id, LAPIC_ICR_FIXED | vector);
+}
+
+void lapic_timer_calibrate()
+{
+    lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_REG_TIMER_INITIAL, 0xFFFFFFFF);
+
+    clock_delay_us(CLOCK_CALIBRATION_MS * 1000);
+
+    uint32_t elapsed = 0xFFFFFFFF - lapic_read(LAPIC_REG_TIMER_CURRENT);
+    lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+    lapic_timer_ticks = elapsed / CLOCK_CALIBRATION_MS;
+}
+
+void lapic_timer_oneshot(uint32_t count)
+{
+    lapic_write(LAPIC_REG_TIMER_DIVIDE, LAPIC_TIMER_DIVIDE_16);
+    // One-shot mode is the default (bits 17-18 are zero)
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_REG_TIMER_INITIAL, count ? count : 1);
+}
+
+void lapic_timer_stop()
+{
+    lapic_write(LAPIC_REG_LVT_TIMER, LAPIC_LVT_MASKED | LAPIC_TIMER_VECTOR);
+    lapic_write(LAPIC_REG_TIMER_INITIAL, 0);
+}
+
+/** @brief the 32 bit counter, it is more than a minute at usual bus clocks */
+static uint64_t lapic_timer_max_cycles()
+{
+    return (uint64_t)(0xFFFFFFFF / lapic_timer_ticks) * clock_tsc_khz();
+}
+
+void lapic_timer_program(uint64_t cycles)
+{
+    // TSC cycles converted to timer ticks
+    uint64_t count = div64(cycles * lapic_timer_ticks, clock_tsc_khz());
+    if (count > 0xFFFFFFFF)
+    {
+        count = 0xFFFFFFFF;
+    }
+
+    lapic_timer_oneshot((uint32_t) count);
+}
+
+struct clock_event* lapic_clock_event()
+{
+    return &lapic_event;
+}
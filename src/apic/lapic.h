@@ -0,0 +1,93 @@
+#ifndef LAPIC_H
+#define LAPIC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timer/timer.h"
+
+/** @file lapic.h
+ * @brief Every CPU has a local APIC. It receives the interrupts of the CPU, has a timer of
+ * its own and sends inter-processor interrupts (IPI) to the other CPUs. Its registers are
+ * memory mapped at the same address on every CPU, each CPU sees its own local APIC there.
+*/
+
+#define LAPIC_DEFAULT_ADDRESS 0xFEE00000
+
+/** @brief register offsets */
+#define LAPIC_REG_ID 0x20
+#define LAPIC_REG_TPR 0x80
+#define LAPIC_REG_EOI 0xB0
+#define LAPIC_REG_SVR 0xF0
+#define LAPIC_REG_ICR_LOW 0x300
+#define LAPIC_REG_ICR_HIGH 0x310
+#define LAPIC_REG_LVT_TIMER 0x320
+#define LAPIC_REG_LVT_LINT0 0x350
+#define LAPIC_REG_LVT_LINT1 0x360
+#define LAPIC_REG_LVT_ERROR 0x370
+#define LAPIC_REG_TIMER_INITIAL 0x380
+#define LAPIC_REG_TIMER_CURRENT 0x390
+#define LAPIC_REG_TIMER_DIVIDE 0x3E0
+
+/** @brief spurious interrupt vector register, bit 8 software enables the local APIC */
+#define LAPIC_SVR_ENABLE 0x100
+
+/** @brief local vector table bits */
+#define LAPIC_LVT_MASKED 0x10000
+#define LAPIC_LVT_NMI 0x400
+#define LAPIC_LVT_EXTINT 0x700
+
+/** @brief interrupt command register bits */
+#define LAPIC_ICR_FIXED 0x4000
+#define LAPIC_ICR_INIT 0x4500
+#define LAPIC_ICR_STARTUP 0x4600
+#define LAPIC_ICR_DELIVERY_PENDING 0x1000
+
+/** @brief the timer counts down at bus clock / 16 */
+#define LAPIC_TIMER_DIVIDE_16 0x03
+
+/** @brief interrupt vectors of the local APIC, they are above the PIC vectors */
+#define LAPIC_TIMER_VECTOR 0x40
+#define LAPIC_RESCHEDULE_VECTOR 0x41
+#define LAPIC_SPURIOUS_VECTOR 0xFF
+
+/** @brief set where the registers are mapped, it is given by the MADT */
+void lapic_init(uint32_t address);
+
+/** @brief whether lapic_init is called, i.e. the machine has a local APIC */
+bool lapic_available();
+
+/** @brief enable the local APIC of the current CPU.
+ * @param bsp the bootstrap CPU takes the NMI through LINT1
+ * @param extint the PIC interrupts come through LINT0 (virtual wire mode), only on the
+ * bootstrap CPU while the IOAPIC is not used
+*/
+void lapic_enable(bool bsp, bool extint);
+
+/** @brief APIC ID of the current CPU */
+uint8_t lapic_id();
+
+/** @brief acknowledge the interrupt being handled */
+void lapic_eoi();
+
+/** @brief send INIT, then STARTUP IPIs making the CPU run real mode code at 'vector' * 4KB */
+void lapic_send_init(uint8_t apic_id);
+void lapic_send_startup(uint8_t apic_id, uint8_t vector);
+
+/** @brief send interrupt 'vector' to the CPU */
+void lapic_send_ipi(uint8_t apic_id, uint8_t vector);
+
+/** @brief measure the timer frequency against the TSC, it is the same on every CPU */
+void lapic_timer_calibrate();
+
+/** @brief fire LAPIC_TIMER_VECTOR once after 'count' timer ticks */
+void lapic_timer_oneshot(uint32_t count);
+void lapic_timer_stop();
+
+/** @brief fire LAPIC_TIMER_VECTOR once after 'cycles' TSC cycles */
+void lapic_timer_program(uint64_t cycles);
+
+/** @brief the timer of the current CPU as the device raising the timer interrupt */
+struct clock_event* lapic_clock_event();
+
+#endif
@@ -0,0 +1,142 @@
+#include "madt.h"
+#include "status.h"
+#include "memory/memory.h"
+
+/** @brief every byte of an ACPI structure adds up to zero */
+static bool madt_checksum_ok(void* data, uint32_t length)
+{
+    uint8_t sum = 0;
+    for (uint32_t i = 0; i < length; i++)
+    {
+        sum += ((uint8_t*) data)[i];
+    }
+
+    return sum == 0;
+}
+
+/** @brief look for the RSDP in the given area, it is aligned to 16 bytes */
+static struct acpi_rsdp* madt_scan_rsdp(uint32_t start, uint32_t length)
+{
+    for (uint32_t address = start; address < start + length; address += 16)
+    {
+        struct acpi_rsdp* rsdp = (struct acpi_rsdp*) address;
+        if (memcmp(rsdp->signature, MADT_RSDP_SIGNATURE, sizeof(rsdp->signature)) == 0 &&
+            madt_checksum_ok(rsdp, sizeof(struct acpi_rsdp)))
+        {
+            return rsdp;
+        }
+    }
+
+    return 0;
+}
+
+static struct acpi_rsdp* madt_find_rsdp()
+{
+    // The real mode segment of the EBDA is kept at 0x40E by the BIOS
+    uint32_t ebda = (uint32_t)(*(uint16_t*) 0x40E) << 4;
+    struct acpi_rsdp* rsdp = 0;
+    if (ebda)
+    {
+        rsdp = madt_scan_rsdp(ebda, 1024);
+    }
+
+    if (!rsdp)
+    {
+        rsdp = madt_scan_rsdp(0xE0000, 0x20000);
+    }
+
+    return rsdp;
+}
+
+static struct madt_header* madt_find(struct acpi_rsdp* rsdp)
+{
+    struct acpi_header* rsdt = (struct acpi_header*) rsdp->rsdt_address;
+    if (memcmp(rsdt->signature, "RSDT", 4) != 0 || !madt_checksum_ok(rsdt, rsdt->length))
+    {
+        return 0;
+    }
+
+    // The RSDT header is followed by 32 bit pointers to the other tables
+    uint32_t total = (rsdt->length - sizeof(struct acpi_header)) / sizeof(uint32_t);
+    uint32_t* tables = (uint32_t*)(rsdt + 1);
+    for (uint32_t i = 0; i < total; i++)
+    {
+        struct acpi_header* header = (struct acpi_header*) tables[i];
+        if (memcmp(header->signature, MADT_SIGNATURE, 4) == 0 && madt_checksum_ok(header, header->length))
+        {
+            return (struct madt_header*) header;
+        }
+    }
+
+    return 0;
+}
+
+int madt_parse(struct madt_info* info)
+{
+    int res = 0;
+    memset(info, 0, sizeof(struct madt_info));
+
+    struct acpi_rsdp* rsdp = madt_find_rsdp();
+    if (!rsdp)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    struct madt_header* madt = madt_find(rsdp);
+    if (!madt)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    info->local_apic_address = madt->local_apic_address;
+
+    // ISA IRQs are identity mapped unless an override entry says otherwise
+    for (int i = 0; i < MADT_ISA_IRQS; i++)
+    {
+        info->irq_gsi[i] = i;
+    }
+
+    uint8_t* current = (uint8_t*)(madt + 1);
+    uint8_t* end = (uint8_t*) madt + madt->header.length;
+    while(current < end)
+    {
+        struct madt_entry* entry = (struct madt_entry*) current;
+        if (entry->length == 0)
+        {
+            break;
+        }
+
+        if (entry->type == MADT_ENTRY_LOCAL_APIC)
+        {
+            struct madt_local_apic* local_apic = (struct madt_local_apic*) entry;
+            if ((local_apic->flags & MADT_LOCAL_APIC_ENABLED) && info->total_cpus < MAEROS_MAX_CPUS)
+            {
+                info->cpu_apic_ids[info->total_cpus++] = local_apic->apic_id;
+            }
+        }
+        else if (entry->type == MADT_ENTRY_IOAPIC && !info->has_ioapic)
+        {
+            // Only the first IOAPIC is used, it handles the ISA interrupts
+            struct madt_ioapic* ioapic = (struct madt_ioapic*) entry;
+            info->has_ioapic = true;
+            info->ioapic_address = ioapic->address;
+            info->ioapic_gsi_base = ioapic->gsi_base;
+        }
+        else if (entry->type == MADT_ENTRY_INTERRUPT_OVERRIDE)
+        {
+            struct madt_interrupt_override* override = (struct madt_interrupt_override*) entry;
+            if (override->source < MADT_ISA_IRQS)
+            {
+                info->irq_gsi[override->source] = override->gsi;
+                info->irq_flags[override->source] = override->flags;
+            }
+        }
+
+        current += entry->length;
+    }
+
+out:
+    return res;
+}
@@ -0,0 +1,123 @@
+#ifndef MADT_H
+#define MADT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+
+/** @file madt.h
+ * @brief The ACPI Multiple APIC Description Table (MADT) lists the local APIC of every CPU
+ * and the IOAPICs of the machine. It is found through the RSDP which the BIOS puts either
+ * into the first kilobyte of the EBDA or into the read-only area 0xE0000 - 0xFFFFF.
+*/
+
+#define MADT_RSDP_SIGNATURE "RSD PTR "
+#define MADT_SIGNATURE "APIC"
+
+/** @brief types of the entries following the MADT header */
+#define MADT_ENTRY_LOCAL_APIC 0
+#define MADT_ENTRY_IOAPIC 1
+#define MADT_ENTRY_INTERRUPT_OVERRIDE 2
+
+/** @brief number of ISA IRQs an override entry can be given for */
+#define MADT_ISA_IRQS 16
+
+/** @brief polarity and trigger mode bits of an override entry, zero means the bus default
+ * which is active high and edge triggered for ISA */
+#define MADT_FLAGS_POLARITY_MASK 0x03
+#define MADT_FLAGS_POLARITY_LOW 0x03
+#define MADT_FLAGS_TRIGGER_MASK 0x0C
+#define MADT_FLAGS_TRIGGER_LEVEL 0x0C
+
+/** @brief the CPU of a local APIC entry can be used */
+#define MADT_LOCAL_APIC_ENABLED 0x01
+
+struct acpi_rsdp
+{
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+} __attribute__((packed));
+
+/** @brief common header of every ACPI table */
+struct acpi_header
+{
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} __attribute__((packed));
+
+struct madt_header
+{
+    struct acpi_header header;
+    /** @brief physical address of the local APIC registers */
+    uint32_t local_apic_address;
+    uint32_t flags;
+} __attribute__((packed));
+
+struct madt_entry
+{
+    uint8_t type;
+    uint8_t length;
+} __attribute__((packed));
+
+struct madt_local_apic
+{
+    struct madt_entry entry;
+    uint8_t processor_id;
+    uint8_t apic_id;
+    uint32_t flags;
+} __attribute__((packed));
+
+struct madt_ioapic
+{
+    struct madt_entry entry;
+    uint8_t ioapic_id;
+    uint8_t reserved;
+    uint32_t address;
+    /** @brief first global system interrupt the IOAPIC handles */
+    uint32_t gsi_base;
+} __attribute__((packed));
+
+/** @brief an ISA IRQ is connected to another IOAPIC input, i.e. the PIT (IRQ 0) to input 2 */
+struct madt_interrupt_override
+{
+    struct madt_entry entry;
+    uint8_t bus;
+    uint8_t source;
+    uint32_t gsi;
+    uint16_t flags;
+} __attribute__((packed));
+
+/** @brief what the kernel needs from the MADT */
+struct madt_info
+{
+    uint32_t local_apic_address;
+
+    int total_cpus;
+    uint8_t cpu_apic_ids[MAEROS_MAX_CPUS];
+
+    bool has_ioapic;
+    uint32_t ioapic_address;
+    uint32_t ioapic_gsi_base;
+
+    /** @brief the global system interrupt and the MADT_FLAGS of each ISA IRQ */
+    uint32_t irq_gsi[MADT_ISA_IRQS];
+    uint16_t irq_flags[MADT_ISA_IRQS];
+};
+
+/** @brief find and parse the MADT
+ * @retval -EIO if the machine has no ACPI tables or no MADT
+*/
+int madt_parse(struct madt_info* info);
+
+#endif
@@ -150,7 +150,7 @@ gdt_descriptor:
 load32:
     ; load into kernel, and jump to it
     mov eax, 1          ; starting sector that we want to load from
-    mov ecx, 100        ; total number of sectors we want to load
+    mov ecx, 199        ; total number of sectors we want to load (all reserved sectors after the boot sector), KERNEL_SECTORS in the Makefile
     mov edi, 0x00100000
     call ata_lba_read   ;talk with the driver and actually load sectors into memory
     jmp CODE_SEG:0x00100000
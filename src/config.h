@@ -43,7 +43,7 @@
 #define MAEROS_MAX_PATH 108
 
 /** @brief number of GDT segments*/
-#define MAEROS_TOTAL_GDT_SEGMENTS 6
+#define MAEROS_TOTAL_GDT_SEGMENTS 7
 
 /** @brief Where default registers are there when task used this when it is started initially */
 #define MAEROS_PROGRAM_VIRTUAL_ADDRESS 0x400000
@@ -51,19 +51,41 @@
 /** @brief 16Kb stack size as default */
 #define MAEROS_USER_PROGRAM_STACK_SIZE 1024 * 16
 
+/** @brief 16Kb kernel stack for each task, syscalls and interrupts of the task run on it */
+#define MAEROS_KERNEL_STACK_SIZE 1024 * 16
+
 /** @brief it is stack address (virtual), it can be same for all task (it physically different) */
 #define MAEROS_PROGRAM_VIRTUAL_STACK_ADDRESS_START 0x3FF000
 
 /** @brief in intel, stack grows from from top do down */
 #define MAEROS_PROGRAM_VIRTUAL_STACK_ADDRESS_END MAEROS_PROGRAM_VIRTUAL_STACK_ADDRESS_START - MAEROS_USER_PROGRAM_STACK_SIZE
 
-/** @brief A process can malloc memory for this amount of maximum
- * @note each malloc is stored in an array specific to this process
- */
-#define MAEROS_MAX_PROGRAM_ALLOCATIONS 1024
+/** @brief where the read-only vDSO data page is seen by every process, the page right
+ * above the stack and below the program (see vdso.h). The stack grows down from its start,
+ * so the page starts there too. */
+#define MAEROS_VDSO_VIRTUAL_ADDRESS MAEROS_PROGRAM_VIRTUAL_STACK_ADDRESS_START
+
+/** @brief Entries of the malloc allocation table of a process when it makes its first malloc,
+ * it is a page. The table doubles when it is three quarters full, there is no upper limit.
+ * It must be a power of two */
+#define MAEROS_PROCESS_ALLOCATIONS_INITIAL 512
+
+/** @brief Maximum number of arguments of a command started through the shell */
+#define MAEROS_MAX_COMMAND_ARGUMENTS 32
 
-/** @brief Maximum number of process allowed */
-#define MAEROS_MAX_PROCESSES 12
+/** @brief Process ids are below it, it is also the limit of the number of processes.
+ * @note it must be a multiple of 32, the ids in use are kept in a bitmap (see task/pid.h)
+*/
+#define MAEROS_MAX_PID 32768
+
+/** @brief Buckets of the process id hash table at boot, it doubles as processes come.
+ * It must be a power of two */
+#define MAEROS_PID_HASH_INITIAL_BUCKETS 16
+
+/** @brief Maximum number of threads of a process, including the main thread.
+ * @note the user stack of each thread is placed right below the stack of the previous one
+*/
+#define MAEROS_MAX_THREADS 8
 
 /** @brief User data segment which means user stack 
  * @note 0x23 comes from GDT table, named structure "gdt_real"
@@ -74,9 +96,57 @@
 */
 #define USER_CODE_SEGMENT 0x1b
 
-/** @brief maximum number of commands that kernel responds to user via 0x80 interrupt */
-#define MAEROS_MAX_ISR80H_COMMANDS 1024
+/** @brief User thread local storage segment, gs holds it in user land
+ * @note 0x30 is the last GDT entry, its base is the thread area of the running task
+*/
+#define USER_TLS_SEGMENT 0x33
+
+/** @brief count the calls and measure the latency of every syscall (see isr80h/stats.h),
+ * set it to 0 to compile the accounting out */
+#define MAEROS_SYSCALL_STATS 1
 
 #define MAEROS_KEYBOARD_BUFFER_SIZE 1024
 
+/** @brief number of timer ticks per second, a tick is the unit of kernel timers
+ * @note the timer interrupt is one-shot, it does not fire at this rate
+*/
+#define MAEROS_TIMER_HZ 100
+
+/** @brief how many timer ticks a task runs before the scheduler switches to the next one */
+#define MAEROS_TASK_QUANTUM_TICKS 5
+
+/** @brief how many page tables paging_new_4gb fills between two preemption points, a
+ * preemption point gives the big kernel lock up so it is not worth it for every table */
+#define MAEROS_PAGING_PREEMPT_TABLES 64
+
+/** @brief maximum number of CPUs brought up, the extra ones listed by ACPI stay halted */
+#define MAEROS_MAX_CPUS 8
+
+/** @brief where the real mode code starting the other CPUs is copied, it must be below 1MB
+ * and 4KB aligned since the CPU starts at (STARTUP IPI vector * 4KB)
+*/
+#define MAEROS_SMP_TRAMPOLINE_ADDRESS 0x70000
+
+/** @brief how long the bootstrap CPU waits for another CPU to start, in milliseconds */
+#define MAEROS_SMP_START_TIMEOUT_MS 100
+
+/** @brief the executable images kept in memory after their programs exit take at most this
+ * many bytes, the least recently used ones are dropped beyond it (see loader/formats/elfcache.h) */
+#define MAEROS_ELF_CACHE_MAX_BYTES (4 * 1024 * 1024)
+
+/** @brief where the first shared library a program needs is mapped, the next one is
+ * MAEROS_SHARED_LIBRARY_MAX_SIZE above it and so on (see loader/formats/elflink.h).
+ * It is above the memory the kernel heap hands to the programs */
+#define MAEROS_SHARED_LIBRARY_VIRTUAL_ADDRESS 0x40000000
+
+/** @brief the address space each shared library gets */
+#define MAEROS_SHARED_LIBRARY_MAX_SIZE 0x01000000
+
+/** @brief the directory the shared libraries are in */
+#define MAEROS_SHARED_LIBRARY_PATH "0:/"
+
+/** @brief bind a function of a shared library when the program first calls it rather than
+ * when it is loaded, set it to 0 to bind every function at load time */
+#define MAEROS_ELF_LAZY_BINDING 1
+
 #endif
\ No newline at end of file
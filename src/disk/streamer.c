@@ -1,6 +1,7 @@
 #include "streamer.h"
 #include "memory/heap/kheap.h"
 #include "config.h"
+#include "task/task.h"
 
 #include <stdbool.h>
 
@@ -26,39 +27,39 @@ int diskstreamer_seek(struct disk_stream* stream, int pos)
 
 int diskstreamer_read(struct disk_stream* stream, void* out, int total)
 {
-    int sector = stream->pos / MAEROS_SECTOR_SIZE;
-    int offset = stream->pos % MAEROS_SECTOR_SIZE;
-    int total_to_read = total;
-    
-    /* if read amount if greater than buffer */
-    bool overflow = (offset+total_to_read) >= MAEROS_SECTOR_SIZE;
-    
+    int res = 0;
     char buf[MAEROS_SECTOR_SIZE];
 
-    if (overflow)
+    /* a sector at a time, it is a loop since the kernel stack of a task is small */
+    while(total > 0)
     {
-        /* how many bytes we can read for remaining size of buffer 
-        rest will be read by calling this function again (at the end of this function)*/
-        total_to_read -= (offset+total_to_read) - MAEROS_SECTOR_SIZE;
-    }
+        int sector = stream->pos / MAEROS_SECTOR_SIZE;
+        int offset = stream->pos % MAEROS_SECTOR_SIZE;
+        int total_to_read = total;
 
-    int res = disk_read_block(stream->disk, sector, 1, buf);
-    if (res < 0)
-    {
-        goto out;
-    }
+        /* if read amount if greater than buffer, rest is read from the next sector */
+        if ((offset+total_to_read) > MAEROS_SECTOR_SIZE)
+        {
+            total_to_read = MAEROS_SECTOR_SIZE - offset;
+        }
 
-   
-    for (int i = 0; i < total_to_read; i++)
-    {
-        *(char*)out++ = buf[offset+i];
-    }
+        res = disk_read_block(stream->disk, sector, 1, buf);
+        if (res < 0)
+        {
+            goto out;
+        }
 
-    // Adjust the stream
-    stream->pos += total_to_read;
-    if (overflow)
-    {
-        res = diskstreamer_read(stream, out, total-total_to_read);
+        for (int i = 0; i < total_to_read; i++)
+        {
+            *(char*)out++ = buf[offset+i];
+        }
+
+        // Adjust the stream
+        stream->pos += total_to_read;
+        total -= total_to_read;
+
+        // Reading a whole file takes long, let the other tasks run in between
+        task_preempt_point();
     }
 out:
     return res;
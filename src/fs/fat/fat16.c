@@ -716,6 +716,7 @@ int fat16_stat(struct disk* disk, void* private, struct file_stat* stat)
     
     /* The information below returns to the user **/
     stat->filesize = ritem->filesize;
+    stat->mtime = ((uint32_t) ritem->last_mod_date << 16) | ritem->last_mod_time;
     /* */
     stat->flags = 0x00;
 
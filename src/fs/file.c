@@ -7,6 +7,7 @@
 #include "fat/fat16.h"
 #include "status.h"
 #include "kernel.h"
+#include "task/mutex.h"
 
 /** @brief file systems array */
 struct filesystem* filesystems[MAEROS_MAX_FILESYSTEMS];
@@ -14,6 +15,10 @@ struct filesystem* filesystems[MAEROS_MAX_FILESYSTEMS];
 /** @brief file descriptors array */
 struct file_descriptor* file_descriptors[MAEROS_MAX_FILE_DESCRIPTORS];
 
+/** @brief serializes the file operations, a long read can be preempted while the filesystem
+ * and the disk are in the middle of it */
+static struct mutex file_lock;
+
 /** @brief get a free file system from file system array */
 static struct filesystem** fs_get_free_filesystem()
 {
@@ -59,6 +64,7 @@ void fs_load()
 void fs_init()
 {
     memset(file_descriptors, 0, sizeof(file_descriptors));
+    mutex_init(&file_lock);
     fs_load();
 }
 
@@ -140,6 +146,7 @@ FILE_MODE file_get_mode_by_string(const char* str)
 int fopen(const char* filename, const char* mode_str)
 {
     int res = 0;
+    mutex_lock(&file_lock);
     struct path_root* root_path = pathparser_parse(filename, NULL);
     if (!root_path)
     {
@@ -194,6 +201,8 @@ int fopen(const char* filename, const char* mode_str)
     res = desc->index;
 
 out:
+    mutex_unlock(&file_lock);
+
     // fopen shouldnt return negative values
     if (res < 0)
         res = 0;
@@ -204,6 +213,7 @@ out:
 int fstat(int fd, struct file_stat* stat)
 {
     int res = 0;
+    mutex_lock(&file_lock);
     struct file_descriptor* desc = file_get_descriptor(fd);
     if (!desc)
     {
@@ -213,12 +223,14 @@ int fstat(int fd, struct file_stat* stat)
 
     res = desc->filesystem->stat(desc->disk, desc->private, stat);
 out:
+    mutex_unlock(&file_lock);
     return res;
 }
 
 int fclose(int fd)
 {
     int res = 0;
+    mutex_lock(&file_lock);
     struct file_descriptor* desc = file_get_descriptor(fd);
     if (!desc)
     {
@@ -232,12 +244,14 @@ int fclose(int fd)
         file_free_descriptor(desc);
     }
 out:
+    mutex_unlock(&file_lock);
     return res;
 }
 
 int fseek(int fd, int offset, FILE_SEEK_MODE whence)
 {
     int res = 0;
+    mutex_lock(&file_lock);
     struct file_descriptor* desc = file_get_descriptor(fd);
     if (!desc)
     {
@@ -247,6 +261,7 @@ int fseek(int fd, int offset, FILE_SEEK_MODE whence)
 
     res = desc->filesystem->seek(desc->private, offset, whence);
 out:
+    mutex_unlock(&file_lock);
     return res;
 }
 
@@ -254,6 +269,7 @@ out:
 int fread(void* ptr, uint32_t size, uint32_t nmemb, int fd)
 {
     int res = 0;
+    mutex_lock(&file_lock);
     if (size == 0 || nmemb == 0 || fd < 1)
     {
         res = -EINVARG;
@@ -269,5 +285,6 @@ int fread(void* ptr, uint32_t size, uint32_t nmemb, int fd)
 
     res = desc->filesystem->read(desc->disk, desc->private, size, nmemb, (char*) ptr);
 out:
+    mutex_unlock(&file_lock);
     return res;
 }
\ No newline at end of file
@@ -41,6 +41,8 @@ struct file_stat
     FILE_STAT_FLAGS flags;
     /** @brief size of the file */
     uint32_t filesize;
+    /** @brief last modification, the date in the high 16 bits and the time in the low ones */
+    uint32_t mtime;
 };
 
 /** @brief Open function prototype */
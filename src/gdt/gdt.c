@@ -32,6 +32,13 @@ void encodeGdtEntry(uint8_t* target, struct gdt_structured source)
 
 }
 
+void gdt_set_base(struct gdt* gdt, uint32_t base)
+{
+    gdt->base_first = base & 0xFFFF;
+    gdt->base = (base >> 16) & 0xFF;
+    gdt->base_24_31_bits = (base >> 24) & 0xFF;
+}
+
 void gdt_structured_to_gdt(struct gdt* gdt, struct gdt_structured* structured_gdt, int total_entires)
 {
     for (int i = 0; i < total_entires; i++)
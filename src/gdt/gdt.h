@@ -49,6 +49,11 @@ struct gdt_structured
 /** @brief load gdt that is CPU can read */
 void gdt_load(struct gdt* gdt, int size);
 
+/** @brief change the base address of a GDT entry, the limit and the type are kept
+ * @note a segment register caches the entry, the change is seen once it is loaded again
+*/
+void gdt_set_base(struct gdt* gdt, uint32_t base);
+
 /** @brief convert structured gdt to normal GDT */
 void gdt_structured_to_gdt(struct gdt* gdt, struct gdt_structured* structured_gdt, int total_entires);
 
@@ -6,7 +6,6 @@ section .asm
 ; handler functions implemented in C code
 ; ------------------------------------------------------------------------------
 extern int21_handler        ; interrupt 21h is keyboard handler
-extern no_interrupt_handler ; exception occured but no handler is set for this exception
 extern isr80h_handler       ; interrupt 80h for printf 
 extern interrupt_handler    ; interrupt handler which expects interrupt number
 ; ------------------------------------------------------------------------------
@@ -16,11 +15,11 @@ extern interrupt_handler    ; interrupt handler which expects interrupt number
 ; function implemented in .Asm file (global function prototypes seen by C files)
 ; ------------------------------------------------------------------------------
 global init21h      ; initialize 21h interrupt which is keyboard interrupt
-global no_interrupt ; no interrupt routine
 global idt_load     ; load interrupt descriptor table via C files. it is global to be seen by C files
                     ; Notice the first parameter to this function will be idt address
 global enable_interrupts        ; enable interrupts
 global disable_interrupts       ; disable interrupts
+global halt_until_interrupt     ; wait for an interrupt while nothing is runnable
 global isr80h_wrapper           ; wrapper for handling interrupt 0x80
 global interrupt_pointer_table  ; interrupt handlers array
 ; ------------------------------------------------------------------------------
@@ -34,6 +33,12 @@ disable_interrupts:
     cli     ; Clear interrupt instruction
     ret
 
+halt_until_interrupt:
+    sti     ; sti takes effect after the next instruction, so no interrupt is lost before hlt
+    hlt     ; sleep until an interrupt is handled
+    cli
+    ret
+
 idt_load:
     push ebp        ;push the base pointer
     
@@ -59,12 +64,6 @@ idt_load:
 ;     sti     ; enable interrupts
 ;     iret    ; interrupt return
 
-no_interrupt:
-    pushad
-    call no_interrupt_handler
-    popad
-    iret
-
 ; create 512 interrupt handlers and declare functions
 ; i is replaced by given argument
 %macro interrupt 1
@@ -123,17 +122,19 @@ isr80h_wrapper:
     ; it will contain the command that our function that our kernel should invoke.
     push eax
     call isr80h_handler
-    mov dword[tmp_res], eax ; eax will have the value for the return result from this function call.
     add esp, 8              ; since we push 2 times, restore the original location
 
+    ; eax has the return result of isr80h_handler, it is written over the saved eax of the
+    ; frame so popad returns it to user land. pushad pushes eax first, so it is the
+    ; highest of the eight saved registers, at [esp+28].
+    ; It stays on the kernel stack of the task, so the CPUs do not share a slot for it
+    mov [esp+28], eax
+
     ; Restore general purpose registers for user land
     popad
-    mov eax, [tmp_res]  ;tmp_res: just for ensuring not corrupt eax register accidentally
     iretd
 
 section .data
-; Inside here is stored the return result from isr80h_handler
-tmp_res: dd 0
 
 ; this macro creates handler function -> int0, int1, ...
 %macro interrupt_array_entry 1
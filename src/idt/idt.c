@@ -6,6 +6,14 @@
 #include "task/task.h"
 #include "status.h"
 #include "task/process.h"
+#include "timer/timer.h"
+#include "smp/smp.h"
+#include "apic/lapic.h"
+#include "irq/irq.h"
+#include "isr80h/ring.h"
+#include "task/vdso.h"
+#include "isr80h/isr80h.h"
+#include "isr80h/sysenter.h"
 
 /**
  * @brief The table (IDT Interrupt Descriptor Table) which holds 
@@ -31,9 +39,6 @@ extern void* interrupt_pointer_table[MAEROS_TOTAL_INTERRUPTS];
 */
 static INTERRUPT_CALLBACK_FUNCTION interrupt_callbacks[MAEROS_TOTAL_INTERRUPTS];
 
-/** @brief The array where we add 0x80 interrupt commands */
-static ISR80H_COMMAND isr80h_commands[MAEROS_MAX_ISR80H_COMMANDS];
-
 /** @brief load interrupt descriptor table via assembly instruction */
 extern void idt_load(struct idtr_desc* ptr);
 
@@ -42,11 +47,6 @@ extern void idt_load(struct idtr_desc* ptr);
 */
 extern void int21h();
 
-/**
- * @brief when there is no interrupt set, decide what will happen in Assembly code
-*/
-extern void no_interrupt();
-
 /** @brief .asm routine triggered when 0x80 interrupt occurs */
 extern void isr80h_wrapper();
 
@@ -59,26 +59,47 @@ extern void isr80h_wrapper();
 //     outb(0x20, 0x20);   //end of the interrupt
 // }
 
-/**
- * @brief when interrupt is not set, this handler is invoked
-*/
-void no_interrupt_handler()
-{
-    outb(0x20, 0x20);   //end of the interrupt
-}
-
-/** @brief interrupt handler */
+/** @brief interrupt handler, every vector enters here (see interrupt_pointer_table). A vector
+ * without a callback is acknowledged like any other one, through irq_end_of_interrupt */
 void interrupt_handler(int interrupt, struct interrupt_frame* frame)
 {
+    kernel_lock();
     kernel_page();
-    if (interrupt_callbacks[interrupt] != 0)
+
+    /* the kernel is only interrupted in a kernel thread or at a preemption point, the
+    saved registers of a task are always the user land ones */
+    bool from_user = (frame->cs & 0x03) != 0;
+    if (from_user)
     {
         task_current_save_state(frame);
+    }
+
+    /* end of interrupt, it is sent first since the callback may switch to another task
+    and we come back here only when this task runs again */
+    irq_end_of_interrupt(interrupt);
+
+    if (interrupt_callbacks[interrupt] != 0)
+    {
         interrupt_callbacks[interrupt](frame);
     }
 
-    task_page();
-    outb(0x20, 0x20); /* end of interrupt */
+    /* the interrupt woke a task up (i.e. key is pressed) while the CPU is idle,
+    run it now rather than waiting for the next timer tick */
+    if (task_is_idle(task_current()) && task_get_next())
+    {
+        task_next();
+    }
+
+    // The process of the task may be terminated by another CPU (see task_stop)
+    task_leave_if_dead();
+
+    task_program_timer();
+    if (from_user)
+    {
+        task_page();
+    }
+
+    kernel_unlock();
 }
 
 /**
@@ -107,9 +128,16 @@ void idt_set(int interrupt_no, void* address)
  * tells the user why the program crashed.
  * potential way of showing what went wrong.
 */
-void idt_handle_exception()
+void idt_handle_exception(struct interrupt_frame* frame)
 {
+    if ((frame->cs & 0x03) == 0)
+    {
+        panic("Exception in kernel mode\n");
+    }
+
     process_terminate(task_current()->process);
+
+    /* notice that we never return from here, the task is stopped */
     task_next();
 }
 
@@ -118,16 +146,35 @@ void idt_handle_exception()
  * 
  * i think it is kind of scheduler implementation
 */
-void idt_clock()
+void idt_clock(struct interrupt_frame* frame)
 {
-    //pic end of interrupt signal!
-    outb(0x20, 0x20);
-    
-    // Switch to the next task
-    //notice that we never return from task->next
+    // Run expired kernel timers, i.e. wake up sleeping tasks
+    timer_tick();
+    vdso_tick();
+
+    // Run the syscalls the program queued up, it does not have to enter the kernel for them
+    if (frame->cs & 0x03)
+    {
+        isr80h_ring_tick();
+    }
+
+    // Keep running the current task until its time slice is used up
+    if (!task_quantum_expired())
+    {
+        return;
+    }
+
+    // Switch to the next task, we are back when this task gets its next time slice
     task_next();
 }
 
+/** @brief another CPU put a task into our run queue, the scheduling is done on the way out
+ * of interrupt_handler
+*/
+static void idt_reschedule()
+{
+}
+
 void idt_init()
 {
     memset(idt_descriptors, 0, sizeof(idt_descriptors));
@@ -157,13 +204,22 @@ void idt_init()
         idt_register_interrupt_callback(i, idt_handle_exception);
     }
     
-    // register timer interrupt
-    idt_register_interrupt_callback(0x20, idt_clock);
+    /* register timer interrupt, it comes from the PIT (IRQ 0) or from the local APIC timer
+    which also ends the time slices on the other CPUs. irq_init unmasks the PIT if it is used */
+    idt_register_interrupt_callback(IRQ_VECTOR_BASE + IRQ_TIMER, idt_clock);
+    idt_register_interrupt_callback(LAPIC_TIMER_VECTOR, idt_clock);
+    idt_register_interrupt_callback(LAPIC_RESCHEDULE_VECTOR, idt_reschedule);
 
     // Load the interrupt descriptor table
     idt_load(&idtr_descriptor);
 }
 
+void idt_init_ap()
+{
+    // The table is shared by all CPUs
+    idt_load(&idtr_descriptor);
+}
+
 /** @brief set a handler for given interrupt number and add to the interrupt callback array */
 int idt_register_interrupt_callback(int interrupt, INTERRUPT_CALLBACK_FUNCTION interrupt_callback)
 {
@@ -178,46 +234,38 @@ int idt_register_interrupt_callback(int interrupt, INTERRUPT_CALLBACK_FUNCTION i
 }
 
 
-/** @brief add syscall to commands table 
- * @note The kernel commands should be reserved only for a
- *  very strict kernel operations for things 
-*/
-void isr80h_register_command(int command_id, ISR80H_COMMAND command)
+/** @brief run the system command 'command' for int 0x80 or SYSENTER. SYSENTER takes the
+ * second and third arguments from the user stack (see sysenter_entry), the command fails
+ * with -EINVARG if they cannot be read. */
+static void* idt_system_call(int command, struct interrupt_frame* frame, bool sysenter)
 {
-    if (command_id < 0 || command_id >= MAEROS_MAX_ISR80H_COMMANDS)
-    {
-        panic("The command is out of bounds\n");
-    }
+    void* res = 0;
 
-    if (isr80h_commands[command_id])
-    {
-        panic("Your attempting to overwrite an existing command\n");
-    }
+    kernel_lock();
+    kernel_page();
 
-    isr80h_commands[command_id] = command;
-}
+    int arguments = sysenter ? sysenter_fetch_arguments(frame) : 0;
 
-/** @brief call required command operation */
-void* isr80h_handle_command(int command, struct interrupt_frame* frame)
-{
-    void* result = 0;
+    /* save registers */
+    task_current_save_state(frame);
 
-    if(command < 0 || command >= MAEROS_MAX_ISR80H_COMMANDS)
+    if (arguments < 0)
     {
-        // Invalid command
-        return 0;
+        res = ERROR(arguments);
+        goto out;
     }
 
-    ISR80H_COMMAND command_func = isr80h_commands[command];
-    if (!command_func)
-    {
-        /* If we are not able to respond user command, which means we do not support for not
-        return zero, but not error */
-        return 0;
-    }
+    res = isr80h_handle_command(command, frame);
+
+out:
+    // The process of the task may be terminated by another CPU meanwhile (see task_stop)
+    task_leave_if_dead();
 
-    result = command_func(frame);
-    return result;
+    task_program_timer();
+    task_page();
+    kernel_unlock();
+
+    return res;
 }
 
 /** @brief In Intel architecture, interrupt 0x80 is used for making system calls 
@@ -226,16 +274,11 @@ void* isr80h_handle_command(int command, struct interrupt_frame* frame)
  * it can do so by triggering interrupt 0x80.*/
 void* isr80h_handler(int command, struct interrupt_frame* frame)
 {
-    void* res = 0;
-
-    kernel_page();
-    
-    /* save registers */
-    task_current_save_state(frame);
+    return idt_system_call(command, frame, false);
+}
 
-    res = isr80h_handle_command(command, frame);
-    
-    task_page();
-    
-    return res;
+/** @brief the system call handler of sysenter_entry */
+void* sysenter_handler(int command, struct interrupt_frame* frame)
+{
+    return idt_system_call(command, frame, true);
 }
\ No newline at end of file
@@ -63,6 +63,9 @@ struct interrupt_frame
 */
 void idt_init();
 
+/** @brief load the interrupt descriptor table on an application processor */
+void idt_init_ap();
+
 /**
  * @brief create descriptor for the given interrupt number at interrupt table
  * descriptor fields are filled according to idt entry format.
@@ -73,9 +76,10 @@ void idt_set(int interrupt_no, void* address);
 void enable_interrupts();
 /** @brief Disabling interrupts (in asm file) */
 void disable_interrupts();
+/** @brief Enable interrupts and halt the CPU until the next interrupt arrives,
+ * interrupts are disabled again when it returns (in asm file) */
+void halt_until_interrupt();
 
-/** @brief add 0x80 command to the command array */
-void isr80h_register_command(int command_id, ISR80H_COMMAND command);
 int idt_register_interrupt_callback(int interrupt, INTERRUPT_CALLBACK_FUNCTION interrupt_callback);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "irq.h"
+#include "pic.h"
+#include "kernel.h"
+#include "status.h"
+#include "apic/lapic.h"
+#include "apic/ioapic.h"
+#include "apic/madt.h"
+#include "timer/timer.h"
+
+/** @brief the interrupt controller handling the IRQs */
+static struct irq_chip* irq_chip = 0;
+
+void irq_init()
+{
+    // The PICs are remapped and masked in any case, they raise spurious interrupts otherwise
+    irq_chip = pic_init();
+
+    struct madt_info info;
+    if (madt_parse(&info) < 0)
+    {
+        // No ACPI, the PIT raises the timer interrupt through the PIC
+        irq_unmask(IRQ_TIMER);
+        goto out;
+    }
+
+    lapic_init(info.local_apic_address);
+    if (info.has_ioapic)
+    {
+        pic_disable();
+        irq_chip = ioapic_init(&info, lapic_id());
+    }
+
+    // The PIC interrupts only come through LINT0 if there is no IOAPIC to route them
+    lapic_enable(true, !info.has_ioapic);
+
+    // The local APIC timer of the BSP takes over the timer interrupt from the PIT
+    lapic_timer_calibrate();
+    timer_set_clock_event(lapic_clock_event());
+
+out:
+    print("Interrupt controller: ");
+    print(irq_chip->name);
+    print("\n");
+}
+
+struct irq_chip* irq_current_chip()
+{
+    return irq_chip;
+}
+
+int irq_register(int irq, INTERRUPT_CALLBACK_FUNCTION callback)
+{
+    if (irq < 0 || irq >= IRQ_TOTAL)
+    {
+        return -EINVARG;
+    }
+
+    int res = idt_register_interrupt_callback(IRQ_VECTOR_BASE + irq, callback);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    irq_unmask(irq);
+    return 0;
+}
+
+void irq_mask(int irq)
+{
+    irq_chip->mask(irq);
+}
+
+void irq_unmask(int irq)
+{
+    irq_chip->unmask(irq);
+}
+
+void irq_end_of_interrupt(int vector)
+{
+    if (vector >= IRQ_VECTOR_BASE && vector < IRQ_VECTOR_BASE + IRQ_TOTAL)
+    {
+        irq_chip->eoi(vector - IRQ_VECTOR_BASE);
+        return;
+    }
+
+    // The interrupts the local APIC raises itself, a spurious one is not acknowledged and
+    // neither is any other vector, i.e. a software interrupt
+    if ((vector == LAPIC_TIMER_VECTOR || vector == LAPIC_RESCHEDULE_VECTOR) && lapic_available())
+    {
+        lapic_eoi();
+    }
+}
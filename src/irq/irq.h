@@ -0,0 +1,55 @@
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdbool.h>
+
+#include "idt/idt.h"
+
+/** @file irq.h
+ * @brief Device interrupts (IRQs) go through an interrupt controller which is either the
+ * legacy 8259 PIC pair or the IOAPIC together with the local APICs. The controller in use
+ * is picked at boot, the drivers only see IRQ numbers.
+*/
+
+/** @brief the ISA IRQs are delivered at vectors 0x20 - 0x2F with either controller */
+#define IRQ_VECTOR_BASE 0x20
+#define IRQ_TOTAL 16
+
+#define IRQ_TIMER 0
+#define IRQ_KEYBOARD 1
+/** @brief the slave PIC is cascaded to the master through this line */
+#define IRQ_CASCADE 2
+
+/** @brief an interrupt controller backend */
+struct irq_chip
+{
+    const char* name;
+
+    /** @brief stop/start delivering the IRQ */
+    void (*mask)(int irq);
+    void (*unmask)(int irq);
+
+    /** @brief acknowledge the IRQ being handled */
+    void (*eoi)(int irq);
+};
+
+/** @brief pick the interrupt controller and the timer interrupt source.
+ * The IOAPIC and the local APIC timer are used if ACPI lists them, otherwise the PIC and PIT.
+ * Every IRQ is masked until a driver registers it.
+*/
+void irq_init();
+
+/** @brief set the handler of the IRQ and unmask it */
+int irq_register(int irq, INTERRUPT_CALLBACK_FUNCTION callback);
+
+void irq_mask(int irq);
+void irq_unmask(int irq);
+
+/** @brief acknowledge interrupt 'vector' to the controller it came from, exceptions and
+ * software interrupts are not acknowledged */
+void irq_end_of_interrupt(int vector);
+
+/** @brief the controller in use */
+struct irq_chip* irq_current_chip();
+
+#endif
@@ -0,0 +1,90 @@
+#include "pic.h"
+#include "io/io.h"
+
+static void pic_mask(int irq);
+static void pic_unmask(int irq);
+static void pic_eoi(int irq);
+
+static struct irq_chip pic_chip = {
+    .name = "8259 PIC",
+    .mask = pic_mask,
+    .unmask = pic_unmask,
+    .eoi = pic_eoi
+};
+
+/** @brief the data port of the PIC handling the IRQ */
+static unsigned short pic_data_port(int irq)
+{
+    return irq < 8 ? PIC_MASTER_DATA_PORT : PIC_SLAVE_DATA_PORT;
+}
+
+static void pic_mask(int irq)
+{
+    unsigned short port = pic_data_port(irq);
+    outb(port, insb(port) | (1 << (irq & 7)));
+}
+
+static void pic_unmask(int irq)
+{
+    unsigned short port = pic_data_port(irq);
+    outb(port, insb(port) & ~(1 << (irq & 7)));
+}
+
+/** @brief whether the PIC is really handling the line, it is not set for a spurious interrupt */
+static bool pic_in_service(unsigned short command_port, int line)
+{
+    outb(command_port, PIC_COMMAND_READ_ISR);
+    return (insb(command_port) & (1 << line)) != 0;
+}
+
+static void pic_eoi(int irq)
+{
+    if (irq < 8)
+    {
+        if (irq == PIC_SPURIOUS_IRQ && !pic_in_service(PIC_MASTER_COMMAND_PORT, PIC_SPURIOUS_IRQ))
+        {
+            return;
+        }
+
+        outb(PIC_MASTER_COMMAND_PORT, PIC_COMMAND_EOI);
+        return;
+    }
+
+    // The master still handled the cascade line for a spurious interrupt of the slave
+    if (irq != 8 + PIC_SPURIOUS_IRQ || pic_in_service(PIC_SLAVE_COMMAND_PORT, PIC_SPURIOUS_IRQ))
+    {
+        outb(PIC_SLAVE_COMMAND_PORT, PIC_COMMAND_EOI);
+    }
+    outb(PIC_MASTER_COMMAND_PORT, PIC_COMMAND_EOI);
+}
+
+struct irq_chip* pic_init()
+{
+    // ICW1, start the initialization sequence of both PICs
+    outb(PIC_MASTER_COMMAND_PORT, PIC_ICW1_INIT);
+    outb(PIC_SLAVE_COMMAND_PORT, PIC_ICW1_INIT);
+
+    // ICW2, vector offsets so that the IRQs do not conflict with the processor exceptions
+    outb(PIC_MASTER_DATA_PORT, IRQ_VECTOR_BASE);
+    outb(PIC_SLAVE_DATA_PORT, IRQ_VECTOR_BASE + 8);
+
+    // ICW3, the slave is on IRQ 2 of the master, and its cascade identity is 2
+    outb(PIC_MASTER_DATA_PORT, 1 << IRQ_CASCADE);
+    outb(PIC_SLAVE_DATA_PORT, IRQ_CASCADE);
+
+    // ICW4
+    outb(PIC_MASTER_DATA_PORT, PIC_ICW4_8086);
+    outb(PIC_SLAVE_DATA_PORT, PIC_ICW4_8086);
+
+    // Mask every line, the drivers unmask the ones they handle
+    outb(PIC_MASTER_DATA_PORT, 0xFF & ~(1 << IRQ_CASCADE));
+    outb(PIC_SLAVE_DATA_PORT, 0xFF);
+
+    return &pic_chip;
+}
+
+void pic_disable()
+{
+    outb(PIC_MASTER_DATA_PORT, 0xFF);
+    outb(PIC_SLAVE_DATA_PORT, 0xFF);
+}
@@ -0,0 +1,35 @@
+#ifndef PIC_H
+#define PIC_H
+
+#include "irq.h"
+
+/** @file pic.h
+ * @brief Two cascaded 8259 Programmable Interrupt Controllers, the master handles IRQ 0 - 7
+ * and the slave IRQ 8 - 15 through IRQ 2 of the master.
+ * See https://wiki.osdev.org/8259_PIC
+*/
+
+#define PIC_MASTER_COMMAND_PORT 0x20
+#define PIC_MASTER_DATA_PORT 0x21
+#define PIC_SLAVE_COMMAND_PORT 0xA0
+#define PIC_SLAVE_DATA_PORT 0xA1
+
+/** @brief ICW1: initialization, ICW4 is given */
+#define PIC_ICW1_INIT 0x11
+/** @brief ICW4: 8086 mode */
+#define PIC_ICW4_8086 0x01
+
+#define PIC_COMMAND_EOI 0x20
+/** @brief OCW3: the next read of the command port returns the in-service register */
+#define PIC_COMMAND_READ_ISR 0x0B
+
+/** @brief the lowest priority line of each PIC, a spurious interrupt comes on it */
+#define PIC_SPURIOUS_IRQ 7
+
+/** @brief remap both PICs to IRQ_VECTOR_BASE and mask every line except the cascade */
+struct irq_chip* pic_init();
+
+/** @brief mask every line, the IOAPIC delivers the IRQs instead */
+void pic_disable();
+
+#endif
@@ -1,12 +1,12 @@
 #ifndef ISR80H_HEAP_H
 #define ISR80H_HEAP_H
 
-struct interrupt_frame;
+#include <stddef.h>
 
 /** @brief syscall function to allocate memory */
-void* isr80h_command4_malloc(struct interrupt_frame* frame);
+void* isr80h_command4_malloc(size_t size);
 
 /** @brief syscall function to free memory */
-void* isr80h_command5_free(struct interrupt_frame* frame);
+void* isr80h_command5_free(void* ptr_to_free);
 
 #endif
\ No newline at end of file
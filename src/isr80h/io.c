@@ -1,30 +1,43 @@
 #include "io.h"
 #include "task/task.h"
+#include "task/process.h"
+#include "task/waitqueue.h"
 #include "keyboard/keyboard.h"
 #include "kernel.h"
+#include "status.h"
 
-void* isr80h_command1_print(struct interrupt_frame* frame)
+void* isr80h_command1_print(const char* user_space_msg_buffer)
 {
-    // first argument is message, pointer shows virtual address
-    void* user_space_msg_buffer = task_get_stack_item(task_current(), 0);
     // the buffer holds the message at kernel space
     char buf[1024];
-    copy_string_from_task(task_current(), user_space_msg_buffer, buf, sizeof(buf));
+    if (strncpy_from_user(task_current(), buf, user_space_msg_buffer, sizeof(buf)) < 0)
+    {
+        return ERROR(-EINVARG);
+    }
 
     print(buf);
     return 0;
 }
 
 
-void* isr80h_command2_getkey(struct interrupt_frame* frame)
+void* isr80h_command2_getkey()
 {
     char c = keyboard_pop();
     return (void*)((int)c);
 }
 
-void* isr80h_command3_putchar(struct interrupt_frame* frame)
+void* isr80h_command3_putchar(char c)
 {
-    char c = (char)(int) task_get_stack_item(task_current(), 0);
     terminal_writechar(c, 15);
     return 0;
-}
\ No newline at end of file
+}
+
+void* isr80h_command10_getkey_block()
+{
+    struct process* process = task_current()->process;
+    /* keyboard interrupt wakes us up when a key is pushed to the buffer */
+    wait_event(&process->keyboard.readers, keyboard_has_key(process));
+
+    char c = keyboard_pop();
+    return (void*)((int)c);
+}
@@ -1,14 +1,15 @@
 #ifndef ISR80H_IO_H
 #define ISR80H_IO_H
 
-struct interrupt_frame;
-
 /** @brief syscall 1: print message to screen */
-void* isr80h_command1_print(struct interrupt_frame* frame);
+void* isr80h_command1_print(const char* user_space_msg_buffer);
 
 /** @brief syscall 2: get keyword when key is pressed */
-void* isr80h_command2_getkey(struct interrupt_frame* frame);
+void* isr80h_command2_getkey();
 
 /** @brief syscall 3: put characters to screen when key is pressed */
-void* isr80h_command3_putchar(struct interrupt_frame* frame);
+void* isr80h_command3_putchar(char c);
+
+/** @brief syscall 10: get pressed key, the task is blocked until a key is pressed */
+void* isr80h_command10_getkey_block();
 #endif
\ No newline at end of file
@@ -4,6 +4,14 @@
 #include "io.h"
 #include "heap.h"
 #include "process.h"
+#include "thread.h"
+#include "ring.h"
+#include "stats.h"
+#include "task/task.h"
+#include "task/process.h"
+#include "timer/clock.h"
+#include "status.h"
+#include "kernel.h"
 
 /**
  * In Intel architecture, interrupt 0x80 is used for making system calls in 
@@ -19,17 +27,48 @@
  * and secure manner.
 */
 
-/** @brief The function registers command (syscalls) to command array (syscall table) */
-void isr80h_register_commands()
+#define ISR80H_ARGUMENTS_0(frame, ...)
+#define ISR80H_ARGUMENTS_1(frame, t0) (t0) (frame)->ebx
+#define ISR80H_ARGUMENTS_2(frame, t0, t1) ISR80H_ARGUMENTS_1(frame, t0), (t1) (frame)->ecx
+#define ISR80H_ARGUMENTS_3(frame, t0, t1, t2) ISR80H_ARGUMENTS_2(frame, t0, t1), (t2) (frame)->edx
+#define ISR80H_ARGUMENTS_4(frame, t0, t1, t2, t3) ISR80H_ARGUMENTS_3(frame, t0, t1, t2), (t3) (frame)->esi
+#define ISR80H_ARGUMENTS_5(frame, t0, t1, t2, t3, t4) ISR80H_ARGUMENTS_4(frame, t0, t1, t2, t3), (t4) (frame)->edi
+
+/** @brief a function per syscall taking its arguments out of the frame, and calling the
+ * handler with them. The handler's own prototype checks the types of the row. */
+#define ISR80H_DISPATCH(command, handler, stub, type, count, types)                                         \
+    static void* handler##_dispatch(struct interrupt_frame* frame)                                         \
+    {                                                                                                       \
+        return handler(MAEROS_SYSCALL_APPLY(ISR80H_ARGUMENTS_##count, frame, MAEROS_SYSCALL_EXPAND types)); \
+    }
+
+MAEROS_SYSCALLS(ISR80H_DISPATCH)
+
+#define ISR80H_TABLE_ENTRY(command, handler, stub, type, count, types) [command] = handler##_dispatch,
+
+/** @brief the syscall table, a command number is an index into it */
+static const ISR80H_COMMAND isr80h_commands[SYSTEM_COMMANDS_TOTAL] = {
+    MAEROS_SYSCALLS(ISR80H_TABLE_ENTRY)
+};
+
+void* isr80h_handle_command(int command, struct interrupt_frame* frame)
 {
-    isr80h_register_command(SYSTEM_COMMAND0_SUM, isr80h_command0_sum);
-    isr80h_register_command(SYSTEM_COMMAND1_PRINT, isr80h_command1_print);
-    isr80h_register_command(SYSTEM_COMMAND2_GETKEY, isr80h_command2_getkey);
-    isr80h_register_command(SYSTEM_COMMAND3_PUTCHAR, isr80h_command3_putchar);
-    isr80h_register_command(SYSTEM_COMMAND4_MALLOC, isr80h_command4_malloc);
-    isr80h_register_command(SYSTEM_COMMAND5_FREE, isr80h_command5_free);
-    isr80h_register_command(SYSTEM_COMMAND6_PROCESS_LOAD_START, isr80h_command6_process_load_start);
-    isr80h_register_command(SYSTEM_COMMAND7_INVOKE_SYSTEM_COMMAND, isr80h_command7_invoke_system_command);
-    isr80h_register_command(SYSTEM_COMMAND8_GET_PROGRAM_ARGUMENTS, isr80h_command8_get_program_arguments);
-    isr80h_register_command(SYSTEM_COMMAND9_EXIT, isr80h_command9_exit);
-}
\ No newline at end of file
+    // Unsigned, so a negative command is out of bounds too
+    if ((unsigned int) command >= SYSTEM_COMMANDS_TOTAL)
+    {
+        return ERROR(-EINVARG);
+    }
+
+#if MAEROS_SYSCALL_STATS
+    /* the process is taken first, a command may switch to another task and come back */
+    struct process* process = task_current()->process;
+    uint64_t start = tsc_read();
+#endif
+
+    void* result = isr80h_commands[command](frame);
+
+#if MAEROS_SYSCALL_STATS
+    isr80h_stats_record(process, command, tsc_read() - start);
+#endif
+    return result;
+}
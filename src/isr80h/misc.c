@@ -1,10 +1,13 @@
 #include "misc.h"
-#include "idt/idt.h"
 #include "task/task.h"
 
-void* isr80h_command0_sum(struct interrupt_frame* frame)
+void* isr80h_command0_sum(int v1, int v2)
 {
-    int v2 = (int) task_get_stack_item(task_current(), 1);
-    int v1 = (int) task_get_stack_item(task_current(), 0);
     return (void*)(v1 + v2);
-}
\ No newline at end of file
+}
+
+void* isr80h_command11_sleep(unsigned int ms)
+{
+    task_sleep(ms);
+    return 0;
+}
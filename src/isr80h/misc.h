@@ -3,9 +3,10 @@
 
 /** @note misc, miscallaneous*/
 
-struct interrupt_frame;
-
 /** @brief The function sums two variable (yeah it is simplest example and helloWorld command)*/
-void* isr80h_command0_sum(struct interrupt_frame* frame);
+void* isr80h_command0_sum(int v1, int v2);
+
+/** @brief syscall 11: put the task to sleep for given milliseconds */
+void* isr80h_command11_sleep(unsigned int ms);
 
 #endif
\ No newline at end of file
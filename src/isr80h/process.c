@@ -5,13 +5,68 @@
 #include "status.h"
 #include "config.h"
 #include "kernel.h"
+#include "memory/heap/kheap.h"
+#include "loader/formats/elflink.h"
+#include "task/workqueue.h"
+#include "task/waitqueue.h"
 
+/** @brief a program load handed to the kernel worker, the syscall sleeps until it is done */
+struct isr80h_process_load
+{
+    struct work work;
+    const char* path;
+
+    /** @brief injected into the new process by the worker, null if there are none */
+    struct command_argument* arguments;
+
+    struct process* process;
+    int res;
+    bool done;
+
+    /** @brief the syscall sleeps here until the worker is done */
+    struct wait_queue done_queue;
+};
+
+/** @brief work item reading and zeroing the image of a program */
+static void isr80h_process_load_work(struct work* work)
+{
+    struct isr80h_process_load* load = work->data;
+    load->res = process_load_switch(load->path, &load->process);
+    if (load->res == 0 && load->arguments)
+    {
+        load->res = process_inject_arguments(load->process, load->arguments);
+    }
+
+    load->done = true;
+    wake_up(&load->done_queue);
+}
+
+/** @brief load the program 'path' in the kernel worker and sleep until it is loaded, so the
+ * disk reads and the zeroing of the segments do not run in the syscall. The other tasks of
+ * this CPU run meanwhile.
+ * @note 'load' is on the kernel stack of the caller. If its process is terminated meanwhile
+ * the stack is freed by the reclaim of the process, the worker runs it after this item.
+*/
+static int isr80h_process_load(const char* path, struct command_argument* arguments, struct process** process)
+{
+    struct isr80h_process_load load = {
+        .path = path,
+        .arguments = arguments,
+    };
+
+    wait_queue_init(&load.done_queue);
+    work_init(&load.work, isr80h_process_load_work, &load);
+    workqueue_schedule(&load.work);
+    wait_event(&load.done_queue, load.done);
+
+    *process = load.process;
+    return load.res;
+}
 
-void* isr80h_command6_process_load_start(struct interrupt_frame* frame)
+void* isr80h_command6_process_load_start(const char* filename_user_ptr)
 {
-    void* filename_user_ptr = task_get_stack_item(task_current(), 0);
     char filename[MAEROS_MAX_PATH];
-    int res = copy_string_from_task(task_current(), filename_user_ptr, filename, sizeof(filename));
+    int res = strncpy_from_user(task_current(), filename, filename_user_ptr, sizeof(filename));
     if (res < 0)
     {
         goto out;
@@ -22,72 +77,158 @@ void* isr80h_command6_process_load_start(struct interrupt_frame* frame)
     strcpy(path+3, filename);
 
     struct process* process = 0;
-    res = process_load_switch(path, &process);
+    res = isr80h_process_load(path, 0, &process);
     if (res < 0)
     {
         goto out;
     }
 
-    task_switch(process->task);
-    task_return(&process->task->registers);
+    // Run the new program right away, we continue once the scheduler picks us again
+    task_yield_to(process->task);
 
 out:
     return 0;
 }
 
+/** @brief free an argument list copied by isr80h_copy_command_arguments */
+static void isr80h_free_command_arguments(struct command_argument* argument)
+{
+    while (argument)
+    {
+        struct command_argument* next = argument->next;
+        kfree(argument);
+        argument = next;
+    }
+}
+
+/** @brief copy the argument list the user gives us into kernel memory, the next pointers
+ * of the list are user addresses as well */
+static int isr80h_copy_command_arguments(void* user_ptr, struct command_argument** out)
+{
+    int res = 0;
+    struct command_argument* root = 0;
+    struct command_argument** tail = &root;
+    for (int i = 0; user_ptr; i++)
+    {
+        // The user could pass a list that loops
+        if (i == MAEROS_MAX_COMMAND_ARGUMENTS)
+        {
+            res = -EINVARG;
+            goto out;
+        }
+
+        struct command_argument* argument = kzalloc(sizeof(struct command_argument));
+        if (!argument)
+        {
+            res = -ENOMEM;
+            goto out;
+        }
+
+        *tail = argument;
+        res = copy_from_user(task_current(), argument, user_ptr, sizeof(struct command_argument));
+        user_ptr = argument->next;
+        argument->next = 0;
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        argument->argument[sizeof(argument->argument) - 1] = 0;
+        tail = &argument->next;
+    }
+
+out:
+    if (ISERR(res))
+    {
+        isr80h_free_command_arguments(root);
+        root = 0;
+    }
+
+    *out = root;
+    return res;
+}
+
 /** @brief invoke a system command 
  * 
  * @note essentially the user land is going to pass us some command arguments and 
  * then we're going to inject those into the process.
 */
-void* isr80h_command7_invoke_system_command(struct interrupt_frame* frame)
+void* isr80h_command7_invoke_system_command(void* arguments_user_ptr)
 {
-    struct command_argument* arguments = task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 0));
-    if (!arguments || strlen(arguments[0].argument) == 0)
+    struct command_argument* root_command_argument = 0;
+    int res = isr80h_copy_command_arguments(arguments_user_ptr, &root_command_argument);
+    if (res < 0)
     {
-        return ERROR(-EINVARG);
+        goto out;
+    }
+
+    if (!root_command_argument || strlen(root_command_argument->argument) == 0)
+    {
+        res = -EINVARG;
+        goto out;
     }
 
     //simple command can be like:: blank.elf arg1 arg2
-    struct command_argument* root_command_argument = &arguments[0];
     const char* program_name = root_command_argument->argument;
 
     char path[MAEROS_MAX_PATH];
     strcpy(path, "0:/");
-    strncpy(path+3, program_name, sizeof(path));
+    strncpy(path+3, program_name, sizeof(path) - 3);
     
     struct process* process = 0;
-    int res = process_load_switch(path, &process);
+    res = isr80h_process_load(path, root_command_argument, &process);
     if (res < 0)
     {
-        return ERROR(res);
-    }
-    
-    res = process_inject_arguments(process, root_command_argument);
-    if (res < 0)
-    {
-        return ERROR(res);
+        goto out;
     }
 
-    task_switch(process->task);
-    task_return(&process->task->registers);
+    // The arguments are in the new process now
+    isr80h_free_command_arguments(root_command_argument);
+    root_command_argument = 0;
 
-    return 0;
+    // Run the new program right away, we continue once the scheduler picks us again
+    task_yield_to(process->task);
+
+out:
+    isr80h_free_command_arguments(root_command_argument);
+    return ERROR(res);
 }
 
-void* isr80h_command8_get_program_arguments(struct interrupt_frame* frame)
+void* isr80h_command8_get_program_arguments(void* arguments_user_ptr)
 {
     struct process* process = task_current()->process;
-    struct process_arguments* arguments = task_virtual_address_to_physical(task_current(), task_get_stack_item(task_current(), 0));
+    struct process_arguments arguments;
 
-    process_get_arguments(process, &arguments->argc, &arguments->argv);
-    return 0;
+    process_get_arguments(process, &arguments.argc, &arguments.argv);
+    int res = copy_to_user(task_current(), arguments_user_ptr, &arguments, sizeof(arguments));
+    return ERROR(res);
 }
 
-void* isr80h_command9_exit(struct interrupt_frame* frame)
+void* isr80h_command9_exit()
 {
     struct process* process = task_current()->process;
     process_terminate(process);
+
+    /* notice that we never return from here, the task is stopped */
     task_next();
     return 0;
-}
\ No newline at end of file
+}
+
+void* isr80h_command19_dl_bind(int index, unsigned int offset)
+{
+    struct process* process = task_current()->process;
+    void* function = 0;
+    if (process->filetype == PROCESS_FILETYPE_ELF)
+    {
+        function = elf_link_bind(process->elf_file, index, offset);
+    }
+
+    if (!function)
+    {
+        // The program would jump to nowhere, it is stopped like on a page fault
+        process_terminate(process);
+        task_next();
+    }
+
+    return function;
+}
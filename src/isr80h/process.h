@@ -5,18 +5,22 @@
  * @brief create a kernel command that allows us to start processes.
 */
 
-struct interrupt_frame;
-
 /** @brief load new process(user process) and start its tasks*/
-void* isr80h_command6_process_load_start(struct interrupt_frame* frame);
+void* isr80h_command6_process_load_start(const char* filename_user_ptr);
 
 /** @brief parse command and pass to process..starting the process and injecting the arguments */
-void* isr80h_command7_invoke_system_command(struct interrupt_frame* frame);
+void* isr80h_command7_invoke_system_command(void* arguments_user_ptr);
 
 /** @brief get program/process arguments given via shell */
-void* isr80h_command8_get_program_arguments(struct interrupt_frame* frame);
+void* isr80h_command8_get_program_arguments(void* arguments_user_ptr);
 
 /** @brief exit/terminate the process/program and runs next task */
-void* isr80h_command9_exit(struct interrupt_frame* frame);
+void* isr80h_command9_exit();
+
+/** @brief bind a function of a shared library the program calls for the first time, the PLT
+ * of the file 'index' pushed the relocation 'offset' (see loader/formats/elflink.h). The
+ * process is terminated if the function cannot be bound.
+ * @retval the address of the function */
+void* isr80h_command19_dl_bind(int index, unsigned int offset);
 
 #endif
\ No newline at end of file
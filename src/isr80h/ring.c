@@ -0,0 +1,137 @@
+#include "ring.h"
+#include "isr80h.h"
+#include "idt/idt.h"
+#include "task/task.h"
+#include "task/process.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+#include "status.h"
+#include "kernel.h"
+#include <stdbool.h>
+
+/** @brief whether 'command' may run in the timer interrupt. It must neither block nor switch
+ * tasks: the interrupt runs on the kernel stack of whatever task it hit, and a command
+ * reaching a preemption point enables interrupts so the next tick would drain the same
+ * ring again on top of it.
+*/
+static bool isr80h_ring_tick_allowed(uint32_t command)
+{
+    switch (command)
+    {
+        case SYSTEM_COMMAND0_SUM:
+        case SYSTEM_COMMAND1_PRINT:
+        case SYSTEM_COMMAND2_GETKEY:
+        case SYSTEM_COMMAND3_PUTCHAR:
+        case SYSTEM_COMMAND4_MALLOC:
+        case SYSTEM_COMMAND5_FREE:
+        case SYSTEM_COMMAND8_GET_PROGRAM_ARGUMENTS:
+        case SYSTEM_COMMAND18_STATS:
+            return true;
+    }
+
+    return false;
+}
+
+/** @brief run up to 'max' queued commands of the ring, it stops early when the completion
+ * ring is full. In the timer interrupt ('from_tick') it also stops at the first command
+ * which may not run there, it stays queued until the next ring_enter.
+ * @retval number of commands run
+*/
+static int isr80h_ring_drain(struct isr80h_ring* ring, int max, bool from_tick)
+{
+    int done = 0;
+    uint32_t tail = ring->submission_tail;
+    while (ring->submission_head != tail && done < max)
+    {
+        if (ring->completion_tail - ring->completion_head >= ISR80H_RING_ENTRIES)
+        {
+            break;
+        }
+
+        if (from_tick && !isr80h_ring_tick_allowed(ring->submissions[ring->submission_head % ISR80H_RING_ENTRIES].command))
+        {
+            break;
+        }
+
+        // The program may change the entry meanwhile, we work on our own copy
+        struct isr80h_ring_submission submission = ring->submissions[ring->submission_head % ISR80H_RING_ENTRIES];
+        ring->submission_head++;
+
+        struct interrupt_frame frame = {};
+        frame.eax = submission.command;
+        frame.ebx = submission.arguments[0];
+        frame.ecx = submission.arguments[1];
+        frame.edx = submission.arguments[2];
+        frame.esi = submission.arguments[3];
+        frame.edi = submission.arguments[4];
+        frame.cs = USER_CODE_SEGMENT;
+        frame.ss = USER_DATA_SEGMENT;
+
+        int result = -EINVARG;
+        if (submission.command != SYSTEM_COMMAND16_RING_SETUP && submission.command != SYSTEM_COMMAND17_RING_ENTER)
+        {
+            result = (int) isr80h_handle_command(submission.command, &frame);
+        }
+
+        struct isr80h_ring_completion* completion = &ring->completions[ring->completion_tail % ISR80H_RING_ENTRIES];
+        completion->user_data = submission.user_data;
+        completion->result = result;
+        ring->completion_tail++;
+        done++;
+    }
+
+    return done;
+}
+
+void* isr80h_command16_ring_setup(int flags)
+{
+    struct process* process = task_current()->process;
+    if (process->ring)
+    {
+        return process->ring;
+    }
+
+    // A heap block is a page, the ring is mapped at the same address in the process
+    struct isr80h_ring* ring = kzalloc(sizeof(struct isr80h_ring));
+    if (!ring)
+    {
+        return ERROR(-ENOMEM);
+    }
+
+    int res = paging_map_to(process->task->page_directory, ring, ring, paging_align_address((void*) ring + sizeof(struct isr80h_ring)), PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
+    if (res < 0)
+    {
+        kfree(ring);
+        return ERROR(res);
+    }
+
+    process->ring = ring;
+    process->ring_flags = flags;
+    return ring;
+}
+
+void* isr80h_command17_ring_enter(int count)
+{
+    struct process* process = task_current()->process;
+    if (!process->ring)
+    {
+        return ERROR(-EINVARG);
+    }
+
+    return (void*) isr80h_ring_drain(process->ring, count, false);
+}
+
+void isr80h_ring_tick()
+{
+    struct task* task = task_current();
+    if (!task || task_is_kernel(task))
+    {
+        return;
+    }
+
+    struct process* process = task->process;
+    if (process->ring && (process->ring_flags & ISR80H_RING_DRAIN_ON_TICK))
+    {
+        isr80h_ring_drain(process->ring, ISR80H_RING_ENTRIES, true);
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef ISR80H_RING_H
+#define ISR80H_RING_H
+
+#include <stdint.h>
+
+/** @file ring.h
+ * @brief Batched system calls. A process queues commands into a submission ring in a page it
+ * shares with the kernel, and the kernel puts the results into a completion ring. One
+ * ring_enter syscall runs all the queued commands, so a program issuing many small
+ * syscalls (i.e. putchar) pays for a single trap. The kernel also drains the ring from the
+ * timer interrupt if the program asks for it, then no trap is needed at all.
+ *
+ * The program only writes submission_tail and completion_head, the kernel only writes
+ * submission_head and completion_tail. The counters are free running, an entry is at
+ * (counter % ISR80H_RING_ENTRIES).
+*/
+
+/** @brief number of entries of each ring, it must be a power of two */
+#define ISR80H_RING_ENTRIES 64
+
+/** @brief drain the ring in the timer interrupt as well, not only in ring_enter. Only the
+ * commands which never block run there (i.e. putchar, malloc), the queue stops at any other
+ * one until the next ring_enter */
+#define ISR80H_RING_DRAIN_ON_TICK 0x01
+
+/** @brief a queued command, the arguments go where ebx, ecx, edx, esi and edi would */
+struct isr80h_ring_submission
+{
+    uint32_t command;
+    uint32_t arguments[5];
+    /** @brief copied into the completion untouched, so the program knows which command it is */
+    uint32_t user_data;
+};
+
+struct isr80h_ring_completion
+{
+    uint32_t user_data;
+    /** @brief what the command returns in eax when it is a syscall */
+    int32_t result;
+};
+
+/** @brief the page shared between the program and the kernel */
+struct isr80h_ring
+{
+    volatile uint32_t submission_head;
+    volatile uint32_t submission_tail;
+    volatile uint32_t completion_head;
+    volatile uint32_t completion_tail;
+
+    struct isr80h_ring_submission submissions[ISR80H_RING_ENTRIES];
+    struct isr80h_ring_completion completions[ISR80H_RING_ENTRIES];
+};
+
+/** @brief syscall 16: map the ring page into the process, returns its address */
+void* isr80h_command16_ring_setup(int flags);
+
+/** @brief syscall 17: run up to 'count' queued commands, returns how many are run */
+void* isr80h_command17_ring_enter(int count);
+
+/** @brief called by the timer interrupt which came from user land, it drains the ring of the
+ * current process if it has asked for it */
+void isr80h_ring_tick();
+
+#endif
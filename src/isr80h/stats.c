@@ -0,0 +1,73 @@
+#include "stats.h"
+#include "isr80h.h"
+#include "task/task.h"
+#include "task/process.h"
+#include "status.h"
+#include "kernel.h"
+
+#if MAEROS_SYSCALL_STATS
+
+/** @brief the totals of all processes */
+static struct isr80h_command_stats isr80h_stats[SYSTEM_COMMANDS_TOTAL];
+
+static void isr80h_stats_add(struct isr80h_command_stats* stats, uint64_t cycles)
+{
+    stats->calls++;
+    stats->total_cycles += cycles;
+    if (cycles > stats->max_cycles)
+    {
+        stats->max_cycles = cycles > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) cycles;
+    }
+
+    int bucket = 0;
+    while (bucket < ISR80H_STATS_BUCKETS - 1 && cycles >= (1ULL << (ISR80H_STATS_FIRST_BUCKET_BITS + bucket)))
+    {
+        bucket++;
+    }
+    stats->histogram[bucket]++;
+}
+
+void isr80h_stats_record(struct process* process, int command, uint64_t cycles)
+{
+    if (command < 0 || command >= SYSTEM_COMMANDS_TOTAL)
+    {
+        return;
+    }
+
+    isr80h_stats_add(&isr80h_stats[command], cycles);
+    if (process)
+    {
+        isr80h_stats_add(&process->syscall_stats[command], cycles);
+    }
+}
+
+void* isr80h_command18_stats(int process_id, int command, void* stats_user_ptr)
+{
+    if (command < 0 || command >= SYSTEM_COMMANDS_TOTAL)
+    {
+        return ERROR(-EINVARG);
+    }
+
+    struct isr80h_command_stats* stats = &isr80h_stats[command];
+    if (process_id != ISR80H_STATS_ALL_PROCESSES)
+    {
+        struct process* process = process_get(process_id);
+        if (!process)
+        {
+            return ERROR(-EINVARG);
+        }
+        stats = &process->syscall_stats[command];
+    }
+
+    int res = copy_to_user(task_current(), stats_user_ptr, stats, sizeof(struct isr80h_command_stats));
+    return ERROR(res);
+}
+
+#else
+
+void* isr80h_command18_stats(int process_id, int command, void* stats_user_ptr)
+{
+    return ERROR(-EUNIMP);
+}
+
+#endif
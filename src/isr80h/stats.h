@@ -0,0 +1,43 @@
+#ifndef ISR80H_STATS_H
+#define ISR80H_STATS_H
+
+#include <stdint.h>
+#include "config.h"
+
+/** @file stats.h
+ * @brief Call count and latency of every syscall, in total and per process, so we can tell
+ * which syscalls a workload spends its time in. The latency is measured in TSC cycles
+ * around the command, a command that blocks (i.e. sleep) counts the time it sleeps.
+ * Commands run through the syscall ring (see ring.h) are counted on their own as well.
+ *
+ * Set MAEROS_SYSCALL_STATS to 0 to compile the accounting out, the stats syscall then
+ * returns -EUNIMP.
+*/
+
+/** @brief number of latency histogram buckets, bucket i counts the calls taking less than
+ * 2^(ISR80H_STATS_FIRST_BUCKET_BITS + i) cycles, the last one counts the longer calls too */
+#define ISR80H_STATS_BUCKETS 16
+#define ISR80H_STATS_FIRST_BUCKET_BITS 7
+
+/** @brief pass it as the process id to the stats syscall to get the totals of all processes */
+#define ISR80H_STATS_ALL_PROCESSES -1
+
+struct process;
+
+struct isr80h_command_stats
+{
+    uint32_t calls;
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint32_t histogram[ISR80H_STATS_BUCKETS];
+};
+
+#if MAEROS_SYSCALL_STATS
+/** @brief account a call of 'command' made by 'process' which took 'cycles' */
+void isr80h_stats_record(struct process* process, int command, uint64_t cycles);
+#endif
+
+/** @brief syscall 18: copy the stats of a command, of a process or of all of them, to the user */
+void* isr80h_command18_stats(int process_id, int command, void* stats_user_ptr);
+
+#endif
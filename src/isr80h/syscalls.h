@@ -0,0 +1,62 @@
+#ifndef ISR80H_SYSCALLS_H
+#define ISR80H_SYSCALLS_H
+
+/** @file syscalls.h
+ * @brief The syscall table, the only place a syscall is defined. The kernel builds its
+ * command numbers, its dispatch table and the unpacking of the arguments from it (see
+ * isr80h.c), and the stdlib builds the user land stubs from it (see peachos.c). The header
+ * is shared with the programs, so it has nothing but the table and the preprocessor helpers.
+ *
+ * A row is X(command, handler, stub, type, count, (argument types)):
+ *  - command, the name of the command number, the number is the position in the table
+ *  - handler, the kernel function, it takes the arguments with their types and returns void*
+ *  - stub, the user land function running the syscall
+ *  - type, what the stub returns
+ *  - count, number of arguments, at most 5. They are passed in ebx, ecx, edx, esi and edi.
+ *
+ * The argument types must be meaningful in the kernel and in user land, a pointer to a
+ * structure is passed as void*. A new syscall is added at the end of the table.
+*/
+#define MAEROS_SYSCALLS(X)                                                                                                  \
+    X(SYSTEM_COMMAND0_SUM, isr80h_command0_sum, maeros_sum, int, 2, (int, int))                                             \
+    X(SYSTEM_COMMAND1_PRINT, isr80h_command1_print, print, void, 1, (const char*))                                          \
+    X(SYSTEM_COMMAND2_GETKEY, isr80h_command2_getkey, peachos_getkey, int, 0, ())                                           \
+    X(SYSTEM_COMMAND3_PUTCHAR, isr80h_command3_putchar, maeros_putchar, void, 1, (char))                                    \
+    X(SYSTEM_COMMAND4_MALLOC, isr80h_command4_malloc, maeros_malloc, void*, 1, (size_t))                                    \
+    X(SYSTEM_COMMAND5_FREE, isr80h_command5_free, maeros_free, void, 1, (void*))                                            \
+    X(SYSTEM_COMMAND6_PROCESS_LOAD_START, isr80h_command6_process_load_start, maeros_process_load_start, void, 1, (const char*)) \
+    X(SYSTEM_COMMAND7_INVOKE_SYSTEM_COMMAND, isr80h_command7_invoke_system_command, maeros_system, int, 1, (void*))        \
+    X(SYSTEM_COMMAND8_GET_PROGRAM_ARGUMENTS, isr80h_command8_get_program_arguments, maeros_process_get_arguments, void, 1, (void*)) \
+    X(SYSTEM_COMMAND9_EXIT, isr80h_command9_exit, maeros_exit, void, 0, ())                                                 \
+    X(SYSTEM_COMMAND10_GETKEY_BLOCK, isr80h_command10_getkey_block, peachos_getkeyblock, int, 0, ())                        \
+    X(SYSTEM_COMMAND11_SLEEP, isr80h_command11_sleep, maeros_sleep, void, 1, (unsigned int))                                \
+    X(SYSTEM_COMMAND12_THREAD_CREATE, isr80h_command12_thread_create, maeros_thread_create_at, int, 3, (void*, void*, void*)) \
+    X(SYSTEM_COMMAND13_THREAD_EXIT, isr80h_command13_thread_exit, maeros_thread_exit, void, 1, (int))                       \
+    X(SYSTEM_COMMAND14_THREAD_JOIN, isr80h_command14_thread_join, maeros_thread_join, int, 2, (int, void*))                 \
+    X(SYSTEM_COMMAND15_SET_THREAD_AREA, isr80h_command15_set_thread_area, maeros_set_thread_area, void, 1, (void*))        \
+    X(SYSTEM_COMMAND16_RING_SETUP, isr80h_command16_ring_setup, maeros_ring_setup, void*, 1, (int))                         \
+    X(SYSTEM_COMMAND17_RING_ENTER, isr80h_command17_ring_enter, maeros_ring_enter, int, 1, (int))                           \
+    X(SYSTEM_COMMAND18_STATS, isr80h_command18_stats, maeros_syscall_stats, int, 3, (int, int, void*))                      \
+    X(SYSTEM_COMMAND19_DL_BIND, isr80h_command19_dl_bind, maeros_dl_bind, void*, 2, (int, unsigned int))
+
+/** @brief the types of a row without their parentheses */
+#define MAEROS_SYSCALL_EXPAND(...) __VA_ARGS__
+/** @brief call 'macro' once its arguments are expanded, i.e. the argument types of a row */
+#define MAEROS_SYSCALL_APPLY(macro, ...) macro(__VA_ARGS__)
+
+#define MAEROS_SYSCALL_ENUM(command, handler, stub, type, count, types) command,
+
+/** @brief Kernel system command list (each command corresponds to
+ * specific request from kernel)
+ * @note the command is passed in eax and the arguments in ebx, ecx, edx, esi and edi.
+ * The result is returned in eax.
+*/
+enum SystemCommands
+{
+    MAEROS_SYSCALLS(MAEROS_SYSCALL_ENUM)
+
+    /** @brief number of commands, it is not a command */
+    SYSTEM_COMMANDS_TOTAL
+};
+
+#endif
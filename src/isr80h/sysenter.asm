@@ -0,0 +1,69 @@
+[BITS 32]
+
+section .asm
+
+global sysenter_entry
+global sysenter_cpu_supported
+global msr_write
+
+extern sysenter_handler
+
+; bool sysenter_cpu_supported()
+; CPUID leaf 1 sets bit 11 (SEP) of edx when SYSENTER/SYSEXIT are there
+sysenter_cpu_supported:
+    push ebx            ; cpuid overwrites ebx, which the C caller expects to be kept
+    mov eax, 1
+    cpuid
+    xor eax, eax
+    bt edx, 11
+    setc al
+    pop ebx
+    ret
+
+; void msr_write(uint32_t msr, uint32_t low, uint32_t high)
+msr_write:
+    mov ecx, [esp+4]
+    mov eax, [esp+8]
+    mov edx, [esp+12]
+    wrmsr
+    ret
+
+; SYSENTER lands here in ring 0 with interrupts disabled. eax holds the command,
+; ebx, esi and edi the first, fourth and fifth arguments, ecx the user stack pointer
+; and edx the user return address. The second and third arguments are on top of the
+; user stack. esp is IA32_SYSENTER_ESP, the TSS of this CPU.
+sysenter_entry:
+    ; tss.esp0 is the kernel stack of the running task
+    mov esp, [esp+4]
+
+    ; INTERRUPT FRAME START
+    ; the same frame int 0x80 gets from the processor
+    push dword 0x23         ; ss
+    push ecx                ; sp
+    pushfd
+    or dword [esp], 0x200   ; user land always runs with interrupts enabled
+    push dword 0x1b         ; cs
+    push edx                ; ip
+
+    ; ecx and edx are filled in from the user stack by sysenter_handler, the user stack
+    ; pointer is not trusted here
+    pushad
+    ; INTERRUPT FRAME END
+
+    push esp
+    push eax
+    call sysenter_handler
+    add esp, 8
+
+    ; return the result to user land in eax, see isr80h_wrapper
+    mov [esp+28], eax
+    popad
+
+    ; SYSEXIT continues at edx with the stack pointer in ecx
+    mov edx, [esp]
+    mov ecx, [esp+12]
+    add esp, 20
+
+    ; sti enables interrupts after the next instruction, so we are in user land by then
+    sti
+    sysexit
@@ -0,0 +1,42 @@
+#include "sysenter.h"
+#include "config.h"
+#include "smp/smp.h"
+#include "idt/idt.h"
+#include "task/task.h"
+
+/** @brief check CPUID for SYSENTER/SYSEXIT */
+bool sysenter_cpu_supported();
+
+/** @brief write a model specific register */
+void msr_write(uint32_t msr, uint32_t low, uint32_t high);
+
+/** @brief .asm routine SYSENTER jumps to */
+void sysenter_entry();
+
+void sysenter_init(struct cpu* cpu)
+{
+    if (!sysenter_cpu_supported())
+    {
+        return;
+    }
+
+    /* SYSENTER loads the kernel code and data segments from here, SYSEXIT the user ones
+    at +16 and +24, which is the order of our GDT */
+    msr_write(IA32_SYSENTER_CS, KERNEL_CODE_SELECTOR, 0);
+    msr_write(IA32_SYSENTER_ESP, (uint32_t) &cpu->tss, 0);
+    msr_write(IA32_SYSENTER_EIP, (uint32_t) sysenter_entry, 0);
+}
+
+int sysenter_fetch_arguments(struct interrupt_frame* frame)
+{
+    uint32_t arguments[2];
+    int res = copy_from_user(task_current(), arguments, (void*) frame->esp, sizeof(arguments));
+    if (res < 0)
+    {
+        return res;
+    }
+
+    frame->ecx = arguments[0];
+    frame->edx = arguments[1];
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef ISR80H_SYSENTER_H
+#define ISR80H_SYSENTER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @file sysenter.h
+ * @brief The fast system call path. SYSENTER/SYSEXIT switch between ring 3 and ring 0 without
+ * the descriptor checks and the stack frame of an interrupt gate. The entry stub builds the
+ * same interrupt frame as int 0x80 so both paths share the system call handling and the commands.
+ * int 0x80 keeps working on every CPU, it is the fallback when SYSENTER is not supported.
+ * SYSENTER uses ecx and edx itself, the stdlib pushes the arguments in them onto the user
+ * stack and sysenter_fetch_arguments puts them back into the frame.
+*/
+
+/** @brief model specific registers programmed for SYSENTER */
+#define IA32_SYSENTER_CS 0x174
+#define IA32_SYSENTER_ESP 0x175
+#define IA32_SYSENTER_EIP 0x176
+
+struct cpu;
+struct interrupt_frame;
+
+/** @brief program the SYSENTER MSRs of the current CPU, it does nothing if SYSENTER is not supported
+ * @note SYSENTER starts on the TSS of the CPU and the entry stub takes tss.esp0 from there,
+ * so nothing has to be reprogrammed when the task and its kernel stack change
+*/
+void sysenter_init(struct cpu* cpu);
+
+/** @brief copy the second and third arguments of a SYSENTER call from the top of the user
+ * stack into ecx and edx of 'frame'. The user stack pointer is not trusted, the words are
+ * read through the page tables of the task, so it must run on the kernel page directory.
+ * @retval 0, or -EINVARG if the user stack is not readable from user land
+*/
+int sysenter_fetch_arguments(struct interrupt_frame* frame);
+
+#endif
@@ -0,0 +1,48 @@
+#include "thread.h"
+#include "task/task.h"
+#include "task/process.h"
+#include "kernel.h"
+#include "smp/smp.h"
+
+void* isr80h_command12_thread_create(void* entry, void* function, void* arg)
+{
+    int res = process_thread_create(task_current()->process, (uint32_t) entry, (uint32_t) function, (uint32_t) arg);
+    return ERROR(res);
+}
+
+void* isr80h_command13_thread_exit(int exit_code)
+{
+    process_thread_exit(task_current(), exit_code);
+
+    /* notice that we never return from here, the thread is stopped */
+    task_next();
+    return 0;
+}
+
+void* isr80h_command14_thread_join(int thread_id, void* exit_code_user_ptr)
+{
+    int exit_code = 0;
+    int res = process_thread_join(task_current()->process, thread_id, &exit_code);
+    if (res < 0)
+    {
+        return ERROR(res);
+    }
+
+    // The exit code is optional
+    if (exit_code_user_ptr)
+    {
+        res = copy_to_user(task_current(), exit_code_user_ptr, &exit_code, sizeof(exit_code));
+    }
+
+    return ERROR(res);
+}
+
+void* isr80h_command15_set_thread_area(void* area)
+{
+    struct task* task = task_current();
+    task->tls_base = (uint32_t) area;
+
+    // gs is loaded again on the way back to user land
+    cpu_set_tls_base(cpu_current(), task->tls_base);
+    return 0;
+}
@@ -0,0 +1,21 @@
+#ifndef ISR80H_THREAD_H
+#define ISR80H_THREAD_H
+
+/** @file thread.h
+ * @brief kernel commands to run more than one thread in a process.
+*/
+
+/** @brief syscall 12: start a thread at 'entry' of the program, which calls 'function(arg)',
+ * returns the thread id */
+void* isr80h_command12_thread_create(void* entry, void* function, void* arg);
+
+/** @brief syscall 13: stop the calling thread, the process exits with its last thread */
+void* isr80h_command13_thread_exit(int exit_code);
+
+/** @brief syscall 14: wait until a thread exits and get its exit code */
+void* isr80h_command14_thread_join(int thread_id, void* exit_code_user_ptr);
+
+/** @brief syscall 15: make gs of the calling thread point at its thread local storage area */
+void* isr80h_command15_set_thread_area(void* area);
+
+#endif
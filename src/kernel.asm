@@ -22,16 +22,8 @@ _start:
     or al, 2
     out 0x92, al
 
-    ; Remap the master PIC (not to conflict processor reserved interrupts 0 - 0x1F)
-    mov al, 00010001b
-    out 0x20, al ; Tell master PIC
-
-    mov al, 0x20 ; Interrupt 0x20 is where master ISR should start
-    out 0x21, al
-
-    mov al, 00000001b
-    out 0x21, al
-    ; End remap of the master PIC
+    ; Both PICs are remapped (not to conflict processor reserved interrupts 0 - 0x1F)
+    ; by irq_init, interrupts stay disabled until then
     
     ;call kernel main function
     call kernel_main
@@ -17,12 +17,16 @@
 
 #include "task/tss.h"
 #include "task/process.h"
+#include "task/workqueue.h"
+#include "smp/smp.h"
 #include "status.h"
 
-#include "isr80h/isr80h.h"
-
 #include "keyboard/keyboard.h"
 
+#include "timer/timer.h"
+#include "irq/irq.h"
+#include "task/fpu.h"
+
 uint16_t* video_mem = 0;
 uint16_t terminal_row = 0;
 uint16_t terminal_col = 0;
@@ -53,17 +57,6 @@ void terminal_writechar(char c, char colour);
 */
 void panic(const char* msg);
 
-struct tss tss;
-struct gdt gdt_real[MAEROS_TOTAL_GDT_SEGMENTS];
-struct gdt_structured gdt_structured[MAEROS_TOTAL_GDT_SEGMENTS] = {
-    {.base = 0x00, .limit = 0x00, .type = 0x00},                 // NULL Segment
-    {.base = 0x00, .limit = 0xffffffff, .type = 0x9a},           // Kernel code segment
-    {.base = 0x00, .limit = 0xffffffff, .type = 0x92},           // Kernel data segment
-    {.base = 0x00, .limit = 0xffffffff, .type = 0xf8},           // User code segment
-    {.base = 0x00, .limit = 0xffffffff, .type = 0xf2},           // User data segment
-    {.base = (uint32_t)&tss, .limit=sizeof(tss), .type = 0xE9}   // TSS Segment
-};
-
 // void pic_timer_callback()
 // {
 //     print("timer handler is activated \n");
@@ -75,12 +68,10 @@ void kernel_main()
     print("Kernel Start\n");
     
     //print("H E L O \n WORLD");
-    memset(gdt_real, 0x00, sizeof(gdt_real));
-    gdt_structured_to_gdt(gdt_real, gdt_structured, MAEROS_TOTAL_GDT_SEGMENTS);
 
-    // Load the gdt
-    gdt_load(gdt_real, sizeof(gdt_real));
-    print("GDT Loaded \n");
+    // Load the GDT and the TSS of the bootstrap CPU, each CPU has its own
+    cpu_init(cpu_current());
+    print("GDT and TSS Loaded \n");
 
     kheap_init();
     print("kernel heap initialized \n");
@@ -98,16 +89,6 @@ void kernel_main()
     idt_init();
     print("idt \n");
 
-    // Setup the TSS
-    memset(&tss, 0x00, sizeof(tss));
-    tss.esp0 = 0x600000;    //where kernel stack is located
-    tss.ss0 = KERNEL_DATA_SELECTOR;
-
-    // Load the TSS, 0x28 is because that would be the offset in the GDT
-    // in the gdt_real once we pass this structure to the function
-    tss_load(0x28);
-    print("TSSegment loaded \n");
-
 
     // Setup paging
     kernel_chunk = paging_new_4gb(PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
@@ -120,9 +101,28 @@ void kernel_main()
     enable_paging();
     print("Enable paging \n");
 
-    // Add syscall to table
-    isr80h_register_commands();
-    print("Register kernel syscalls \n");
+    // Calibrate the clocksource and initialize the kernel timers
+    timer_init();
+    print("Timer initialized \n");
+
+    // Pick the interrupt controller, every IRQ stays masked until its driver registers it
+    irq_init();
+
+    // Enable the FPU and SSE for user programs, their registers are switched lazily
+    fpu_init();
+    print("FPU initialized \n");
+
+    // Create the task that runs when nothing else is runnable
+    task_idle_init(cpu_current());
+    print("Idle task created \n");
+
+    // Start the kernel worker which runs deferred work
+    workqueue_kernel_init();
+    print("Kernel work queue started \n");
+
+    // Start the other CPUs, they idle until the first task runs
+    smp_init();
+    print("SMP initialized \n");
 
     // Initialize all keyboard in system
     keyboard_init();
@@ -225,6 +225,12 @@ void kernel_main()
     while(1);
 }
 
+/** @brief return the kernel page directory, kernel mode tasks run on it */
+struct paging_4gb_chunk* kernel_paging_chunk()
+{
+    return kernel_chunk;
+}
+
 /** @brief this will switch the page directory to the kernel page directory. 
  * And it will also change the registers to the kernel registers.
 */
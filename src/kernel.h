@@ -1,6 +1,8 @@
 #ifndef KERNEL_H
 #define KERNEL_H
 
+#include <stdint.h>
+
 #define VGA_WIDTH 80
 #define VGA_HEIGHT 20
 
@@ -19,6 +21,9 @@ void panic(const char* msg);
 void kernel_page();
 void kernel_registers();
 
+struct paging_4gb_chunk;
+struct paging_4gb_chunk* kernel_paging_chunk();
+
 
 #define ERROR(value) (void*)(value)
 #define ERROR_I(value) (int)(value)
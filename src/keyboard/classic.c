@@ -2,7 +2,7 @@
 #include "keyboard.h"
 #include "io/io.h"
 #include "kernel.h"
-#include "idt/idt.h"
+#include "irq/irq.h"
 #include "task/task.h"
 
 #include <stdint.h>
@@ -45,8 +45,8 @@ void classic_keyboard_handle_interrupt();
 
 int classic_keyboard_init()
 {
-    // set interrupt handler for keyboard interrupt number
-    idt_register_interrupt_callback(ISR_KEYBOARD_INTERRUPT, classic_keyboard_handle_interrupt);
+    // set interrupt handler for keyboard interrupt, it is unmasked at the interrupt controller
+    irq_register(IRQ_KEYBOARD, classic_keyboard_handle_interrupt);
 
     keyboard_set_capslock(&classic_keyboard, KEYBOARD_CAPS_LOCK_OFF);
 
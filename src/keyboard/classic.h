@@ -26,9 +26,6 @@
 /** @brief scan code for key is released*/
 #define CLASSIC_KEYBOARD_KEY_RELEASED 0x80
 
-/** @brief keyboard interrupt number when any key is pressed */
-#define ISR_KEYBOARD_INTERRUPT 0x21
-
 /** @brief it is the data port of PS2 keyword */
 #define KEYBOARD_INPUT_PORT 0x60
 
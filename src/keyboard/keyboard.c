@@ -3,6 +3,7 @@
 #include "kernel.h"
 #include "task/process.h"
 #include "task/task.h"
+#include "task/waitqueue.h"
 #include "classic.h"
 
 /** @brief Keyboard list head, first keyboard in system */
@@ -89,6 +90,16 @@ void keyboard_push(char c)
     int real_index = keyboard_get_tail_index(process);
     process->keyboard.buffer[real_index] = c;
     process->keyboard.tail++;
+
+    // wake up tasks which are waiting for a key
+    wake_up(&process->keyboard.readers);
+}
+
+/** @brief return whether there is a key in the process keyboard buffer to be popped */
+bool keyboard_has_key(struct process* process)
+{
+    int real_index = process->keyboard.head % sizeof(process->keyboard.buffer);
+    return process->keyboard.buffer[real_index] != 0x00;
 }
 
 char keyboard_pop()
@@ -1,6 +1,8 @@
 #ifndef KEYBOARD_H
 #define KEYBOARD_H
 
+#include <stdbool.h>
+
 #define KEYBOARD_CAPS_LOCK_ON 1
 #define KEYBOARD_CAPS_LOCK_OFF 0
 
@@ -38,6 +40,9 @@ void keyboard_push(char c);
  * (get which key is pressed of keyboard)*/
 char keyboard_pop();
 
+/** @brief check whether the process has a key waiting in its keyboard buffer */
+bool keyboard_has_key(struct process* process);
+
 /** @brief add a keyboard to keyboard linked list. Note that
  * keyboard must have initialization function
  */
@@ -86,6 +86,47 @@ segment. */
 
 #define SHN_UNDEF 0
 
+/***** Dynamic Section Tags *****/
+#define DT_NULL 0
+#define DT_NEEDED 1
+#define DT_PLTRELSZ 2
+#define DT_PLTGOT 3
+#define DT_HASH 4
+#define DT_STRTAB 5
+#define DT_SYMTAB 6
+#define DT_RELA 7
+#define DT_RELASZ 8
+#define DT_RELAENT 9
+#define DT_STRSZ 10
+#define DT_SYMENT 11
+#define DT_REL 17
+#define DT_RELSZ 18
+#define DT_RELENT 19
+#define DT_PLTREL 20
+#define DT_TEXTREL 22
+#define DT_JMPREL 23
+
+/***** Symbol Binding *****/
+#define STB_LOCAL 0
+#define STB_GLOBAL 1
+#define STB_WEAK 2
+
+/** @brief the binding of a symbol is the high four bits of st_info */
+#define ELF32_ST_BIND(info) ((info) >> 4)
+
+/***** i386 Relocation Types *****/
+#define R_386_NONE 0
+#define R_386_32 1
+#define R_386_PC32 2
+#define R_386_COPY 5
+#define R_386_GLOB_DAT 6
+#define R_386_JMP_SLOT 7
+#define R_386_RELATIVE 8
+
+/** @brief the symbol table index and the type of a relocation are packed into r_info */
+#define ELF32_R_SYM(info) ((info) >> 8)
+#define ELF32_R_TYPE(info) ((unsigned char)(info))
+
 typedef uint16_t elf32_half;
 typedef uint32_t elf32_word;
 typedef int32_t elf32_sword;
@@ -174,6 +215,14 @@ struct elf32_sym
     elf32_half st_shndx;
 } __attribute__((packed));
 
+/** @brief relocation entry without an explicit addend, the addend is the word it patches */
+struct elf32_rel
+{
+    /** @brief the address of the word to patch */
+    elf32_addr r_offset;
+    elf32_word r_info;
+} __attribute__((packed));
+
 /** @brief the function returns the entry point of a process */
 void* elf_get_entry_ptr(struct elf_header* elf_header);
 
@@ -0,0 +1,469 @@
+#include "elfcache.h"
+#include "elfloader.h"
+#include "elfz.h"
+#include "lz4.h"
+#include <stdbool.h>
+#include "fs/file.h"
+#include "status.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "string/string.h"
+#include "kernel.h"
+#include "memory/paging/paging.h"
+
+/** @brief the cached images, the most recently used one first */
+static struct elf_image* elf_cache_head = 0;
+static struct elf_image* elf_cache_tail = 0;
+
+/** @brief bytes of file data held by the cached images */
+static uint32_t elf_cache_bytes = 0;
+
+static void elf_cache_unlink(struct elf_image* image)
+{
+    if (image->prev)
+    {
+        image->prev->next = image->next;
+    }
+    else
+    {
+        elf_cache_head = image->next;
+    }
+
+    if (image->next)
+    {
+        image->next->prev = image->prev;
+    }
+    else
+    {
+        elf_cache_tail = image->prev;
+    }
+
+    image->next = 0;
+    image->prev = 0;
+}
+
+static void elf_cache_link_first(struct elf_image* image)
+{
+    image->prev = 0;
+    image->next = elf_cache_head;
+    if (elf_cache_head)
+    {
+        elf_cache_head->prev = image;
+    }
+    elf_cache_head = image;
+
+    if (!elf_cache_tail)
+    {
+        elf_cache_tail = image;
+    }
+}
+
+static void elf_cache_free(struct elf_image* image)
+{
+    for (int i = 0; i < image->total_segments; i++)
+    {
+        kfree(image->segments[i].memory);
+    }
+
+    if (image->memory)
+    {
+        kfree(image->memory);
+    }
+    kfree(image);
+}
+
+/** @brief drop the least recently used images nobody references until the cache holds at
+ * most 'max_bytes' */
+static uint32_t elf_cache_evict(uint32_t max_bytes)
+{
+    uint32_t freed = 0;
+    struct elf_image* image = elf_cache_tail;
+    while (image && elf_cache_bytes > max_bytes)
+    {
+        struct elf_image* prev = image->prev;
+        if (image->refcount == 0)
+        {
+            elf_cache_unlink(image);
+            elf_cache_bytes -= image->size;
+            freed += image->size;
+            elf_cache_free(image);
+        }
+        image = prev;
+    }
+
+    return freed;
+}
+
+uint32_t elf_cache_shrink()
+{
+    return elf_cache_evict(0);
+}
+
+/** @brief kzalloc which drops the unused images and tries again when the heap is full */
+static void* elf_cache_alloc(size_t size)
+{
+    void* ptr = kzalloc(size);
+    if (!ptr && elf_cache_shrink() > 0)
+    {
+        ptr = kzalloc(size);
+    }
+
+    return ptr;
+}
+
+static struct elf_image* elf_cache_find(const char* filename)
+{
+    for (struct elf_image* image = elf_cache_head; image; image = image->next)
+    {
+        if (strncmp(image->filename, filename, sizeof(image->filename)) == 0)
+        {
+            return image;
+        }
+    }
+
+    return 0;
+}
+
+/** @brief whether the segment 'phdr' lies where its file is mapped in user land. A program is
+ * mapped at its own addresses, above the stack and the vDSO page and below the shared
+ * libraries. A library is mapped at its load bias, it must fit into its slot.
+*/
+static bool elf_cache_segment_in_range(struct elf_header* header, struct elf32_phdr* phdr)
+{
+    if (phdr->p_memsz > UINT32_MAX - phdr->p_vaddr)
+    {
+        return false;
+    }
+
+    uint32_t end = phdr->p_vaddr + phdr->p_memsz;
+    if (header->e_type == ET_DYN)
+    {
+        return end <= MAEROS_SHARED_LIBRARY_MAX_SIZE;
+    }
+
+    return phdr->p_vaddr >= MAEROS_PROGRAM_VIRTUAL_ADDRESS && end <= MAEROS_SHARED_LIBRARY_VIRTUAL_ADDRESS;
+}
+
+/** @brief read the PT_LOAD segment 'phdr' of the file into pages of its own, the pages are
+ * zeroed first so the part the file does not cover (.bss) is zero. The data is decompressed
+ * into the pages while it is read if the file is a container ('compressed' is not null).
+*/
+static int elf_cache_read_segment(int fd, struct file_stat* stat, struct elf_image* image, struct elf32_phdr* phdr, struct elfz_segment* compressed)
+{
+    if (image->total_segments >= ELF_MAX_SEGMENTS || phdr->p_filesz > phdr->p_memsz ||
+        !elf_cache_segment_in_range(image->memory, phdr))
+    {
+        return -EINFORMAT;
+    }
+
+    // Written so that it does not wrap around, the offset and the size come from the file
+    uint32_t offset = compressed ? compressed->offset : phdr->p_offset;
+    uint32_t file_size = compressed ? compressed->compressed_size : phdr->p_filesz;
+    if (offset > stat->filesize || file_size > stat->filesize - offset)
+    {
+        return -EINFORMAT;
+    }
+
+    struct elf_segment* segment = &image->segments[image->total_segments];
+    segment->phdr = phdr;
+    segment->virtual_address = paging_align_to_lower_page((void*) phdr->p_vaddr);
+    segment->size = paging_align_address((void*)(phdr->p_vaddr + phdr->p_memsz)) - segment->virtual_address;
+    segment->memory = elf_cache_alloc(segment->size);
+    if (!segment->memory)
+    {
+        return -ENOMEM;
+    }
+    image->total_segments++;
+    image->size += segment->size;
+
+    if (phdr->p_filesz == 0)
+    {
+        return 0;
+    }
+
+    int res = fseek(fd, offset, SEEK_SET);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    void* data = segment->memory + (phdr->p_vaddr - (uint32_t) segment->virtual_address);
+    if (!compressed)
+    {
+        return fread(data, phdr->p_filesz, 1, fd) == 1 ? 0 : -EIO;
+    }
+
+    res = lz4_decompress_file(fd, file_size, data, phdr->p_filesz);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    return (uint32_t) res == phdr->p_filesz ? 0 : -EINFORMAT;
+}
+
+/** @brief whether the file starting with 'header' is an ELF file in an elfz container */
+static bool elf_cache_is_container(struct elfz_header* header)
+{
+    return header->magic[0] == ELFZ_MAGIC0 && header->magic[1] == ELFZ_MAGIC1 &&
+           header->magic[2] == ELFZ_MAGIC2 && header->magic[3] == ELFZ_MAGIC3;
+}
+
+/** @brief read the headers and the segments of the file 'filename' into a new image */
+static int elf_cache_read(const char* filename, struct elf_image** image_out)
+{
+    int res = 0;
+    struct elf_image* image = 0;
+    struct elfz_segment* table = 0;
+    int fd = fopen(filename, "r");
+    if (fd <= 0)
+    {
+        fd = 0;
+        res = -EIO;
+        goto out;
+    }
+
+    struct file_stat stat;
+    res = fstat(fd, &stat);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    struct elf_header header;
+    if (stat.filesize < sizeof(header))
+    {
+        res = -EINFORMAT;
+        goto out;
+    }
+
+    if (fread(&header, sizeof(header), 1, fd) != 1)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    // A container has its own header, the ELF header and the program headers follow it
+    bool container = elf_cache_is_container((struct elfz_header*) &header);
+    if (container)
+    {
+        if (((struct elfz_header*) &header)->version != ELFZ_VERSION || stat.filesize < sizeof(struct elfz_header) + sizeof(header))
+        {
+            res = -EINFORMAT;
+            goto out;
+        }
+
+        res = fseek(fd, sizeof(struct elfz_header), SEEK_SET);
+        if (res < 0)
+        {
+            goto out;
+        }
+
+        if (fread(&header, sizeof(header), 1, fd) != 1)
+        {
+            res = -EIO;
+            goto out;
+        }
+    }
+
+    res = elf_validate_loaded(&header);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    uint32_t phoff = container ? sizeof(struct elfz_header) + sizeof(header) : header.e_phoff;
+    uint32_t phdrs_size = header.e_phnum * sizeof(struct elf32_phdr);
+    uint32_t table_size = container ? header.e_phnum * sizeof(struct elfz_segment) : 0;
+    if (header.e_phentsize != sizeof(struct elf32_phdr) || phoff > stat.filesize ||
+        phdrs_size + table_size > stat.filesize - phoff)
+    {
+        res = -EINFORMAT;
+        goto out;
+    }
+
+    image = elf_cache_alloc(sizeof(struct elf_image));
+    if (!image)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    image->size = sizeof(header) + phdrs_size;
+    image->memory = elf_cache_alloc(image->size);
+    if (!image->memory)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    res = fseek(fd, phoff, SEEK_SET);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    if (fread(image->memory + sizeof(header), phdrs_size, 1, fd) != 1)
+    {
+        res = -EIO;
+        goto out;
+    }
+
+    // The segment table of the container is right after the program headers
+    if (container)
+    {
+        table = kzalloc(table_size);
+        if (!table)
+        {
+            res = -ENOMEM;
+            goto out;
+        }
+
+        if (fread(table, table_size, 1, fd) != 1)
+        {
+            res = -EIO;
+            goto out;
+        }
+    }
+
+    // The program headers follow the ELF header in memory, there are no section headers
+    header.e_phoff = sizeof(header);
+    header.e_shoff = 0;
+    header.e_shnum = 0;
+    header.e_shstrndx = 0;
+    memcpy(image->memory, &header, sizeof(header));
+
+    for (int i = 0; i < header.e_phnum; i++)
+    {
+        struct elf32_phdr* phdr = elf_program_header(image->memory, i);
+        if (phdr->p_type != PT_LOAD)
+        {
+            continue;
+        }
+
+        res = elf_cache_read_segment(fd, &stat, image, phdr, table ? &table[i] : 0);
+        if (res < 0)
+        {
+            goto out;
+        }
+    }
+
+    strncpy(image->filename, filename, sizeof(image->filename));
+    image->mtime = stat.mtime;
+    *image_out = image;
+
+out:
+    if (res < 0 && image)
+    {
+        elf_cache_free(image);
+    }
+
+    if (table)
+    {
+        kfree(table);
+    }
+
+    if (fd)
+    {
+        fclose(fd);
+    }
+    return res;
+}
+
+/** @brief the modification time of the file 'filename', only its directory entry is read */
+static int elf_cache_mtime(const char* filename, uint32_t* mtime)
+{
+    int fd = fopen(filename, "r");
+    if (fd <= 0)
+    {
+        return -EIO;
+    }
+
+    struct file_stat stat;
+    int res = fstat(fd, &stat);
+    if (res == 0)
+    {
+        *mtime = stat.mtime;
+    }
+
+    fclose(fd);
+    return res;
+}
+
+int elf_cache_get(const char* filename, struct elf_image** image_out)
+{
+    uint32_t mtime = 0;
+    int res = elf_cache_mtime(filename, &mtime);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    struct elf_image* image = elf_cache_find(filename);
+    if (image && image->mtime != mtime)
+    {
+        // The file is modified since it was read, the programs running the old image keep it
+        elf_cache_invalidate(filename);
+        image = 0;
+    }
+
+    if (image)
+    {
+        elf_cache_unlink(image);
+    }
+    else
+    {
+        res = elf_cache_read(filename, &image);
+        if (res < 0)
+        {
+            return res;
+        }
+        elf_cache_bytes += image->size;
+    }
+
+    image->refcount++;
+    elf_cache_link_first(image);
+    elf_cache_evict(MAEROS_ELF_CACHE_MAX_BYTES);
+
+    *image_out = image;
+    return 0;
+}
+
+void elf_cache_put(struct elf_image* image)
+{
+    if (!image)
+    {
+        return;
+    }
+
+    image->refcount--;
+
+    // An invalidated image is not in the cache, the last user frees it
+    if (image->refcount == 0 && image->filename[0] == 0)
+    {
+        elf_cache_free(image);
+        return;
+    }
+
+    elf_cache_evict(MAEROS_ELF_CACHE_MAX_BYTES);
+}
+
+void elf_cache_invalidate(const char* filename)
+{
+    struct elf_image* image = elf_cache_find(filename);
+    if (!image)
+    {
+        return;
+    }
+
+    elf_cache_unlink(image);
+    elf_cache_bytes -= image->size;
+    if (image->refcount == 0)
+    {
+        elf_cache_free(image);
+        return;
+    }
+
+    // The programs running it keep it until they exit
+    image->filename[0] = 0;
+}
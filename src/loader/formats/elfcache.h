@@ -0,0 +1,65 @@
+#ifndef ELFCACHE_H
+#define ELFCACHE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "elfloader.h"
+
+/** @file elfcache.h
+ * @brief Executable images kept in memory, so launching a program again does not read it
+ * from the disk. An image is the ELF header, the program headers and the PT_LOAD segments
+ * of the file, each segment in pages of its own with its .bss zeroed. Only those ranges are
+ * read, the section headers and the debug information are skipped.
+ *
+ * An image is keyed by the path and the modification time of the file. On a hit the file
+ * is opened and stat'ed, that reads its directory entry but none of its data. An image of a
+ * file modified since is invalidated and the file is read again.
+ *
+ * Every loaded elf_file holds a reference to its image for the lifetime of its process.
+ * The images nobody references are dropped in least recently used order, when they take
+ * more than MAEROS_ELF_CACHE_MAX_BYTES or when the kernel heap runs out.
+*/
+
+struct elf_image
+{
+    char filename[MAEROS_MAX_PATH];
+
+    /** @brief modification time of the file when it was read, see struct file_stat */
+    uint32_t mtime;
+
+    /** @brief bytes of memory held by the image */
+    uint32_t size;
+
+    /** @brief the ELF header followed by the program headers, it must not be written */
+    void* memory;
+
+    /** @brief the PT_LOAD segments in program header order, they must not be written */
+    struct elf_segment segments[ELF_MAX_SEGMENTS];
+    int total_segments;
+
+    /** @brief number of elf files using the image, it is not dropped while it is not zero */
+    int refcount;
+
+    /** @brief all images, the most recently used one first */
+    struct elf_image* next;
+    struct elf_image* prev;
+};
+
+/** @brief take a reference to the image of 'filename', it is read from the disk unless it
+ * is in the cache and the file is not modified since
+ * @retval 0 on success, -EINFORMAT if the file is not an ELF file, or another negative code
+*/
+int elf_cache_get(const char* filename, struct elf_image** image_out);
+
+/** @brief give back a reference taken by elf_cache_get, the image stays cached */
+void elf_cache_put(struct elf_image* image);
+
+/** @brief the file 'filename' has changed, its image is not handed out again */
+void elf_cache_invalidate(const char* filename);
+
+/** @brief drop every image nobody references, i.e. when the kernel heap runs out
+ * @retval number of bytes given back
+*/
+uint32_t elf_cache_shrink();
+
+#endif
@@ -0,0 +1,525 @@
+#include "elflink.h"
+#include "status.h"
+#include "config.h"
+#include <stdbool.h>
+#include "memory/memory.h"
+#include "string/string.h"
+
+/** @brief where a symbol is defined, no file for an undefined weak symbol */
+struct elf_link_symbol
+{
+    struct elf_file* file;
+    struct elf32_sym* symbol;
+};
+
+/** @brief the memory of 'size' bytes at address 'address' of the file if a writable segment
+ * covers them, the read-only ones are shared with the other processes */
+static void* elf_link_writable(struct elf_file* file, uint32_t address, uint32_t size)
+{
+    for (int i = 0; i < file->total_segments; i++)
+    {
+        struct elf_segment* segment = &file->segments[i];
+        uint32_t start = (uint32_t) segment->virtual_address;
+        if (!(segment->phdr->p_flags & PF_W))
+        {
+            continue;
+        }
+
+        if (address >= start && size <= segment->size && address - start <= segment->size - size)
+        {
+            return segment->memory + (address - start);
+        }
+    }
+
+    return 0;
+}
+
+/** @brief the string at 'offset' of the string table, null unless it ends inside the table */
+static const char* elf_link_string(struct elf_file* file, uint32_t offset)
+{
+    struct elf_dynamic* dynamic = &file->dynamic;
+    if (offset >= dynamic->strings_size)
+    {
+        return 0;
+    }
+
+    int max = dynamic->strings_size - offset;
+    if (strnlen(dynamic->strings + offset, max) == max)
+    {
+        return 0;
+    }
+
+    return dynamic->strings + offset;
+}
+
+/** @brief the hash of the symbol names in DT_HASH, as the System V ABI defines it */
+static uint32_t elf_link_hash(const char* name)
+{
+    uint32_t hash = 0;
+    while (*name)
+    {
+        hash = (hash << 4) + (unsigned char) *name++;
+        uint32_t high = hash & 0xf0000000;
+        if (high)
+        {
+            hash ^= high >> 24;
+        }
+        hash &= ~high;
+    }
+
+    return hash;
+}
+
+static uint32_t elf_link_symbol_count(struct elf_file* file)
+{
+    return file->dynamic.hash ? file->dynamic.hash[1] : 0;
+}
+
+/** @brief the definition of 'name' in 'file', or null if the file does not define it */
+static struct elf32_sym* elf_link_find(struct elf_file* file, const char* name, uint32_t hash)
+{
+    struct elf_dynamic* dynamic = &file->dynamic;
+    if (!dynamic->hash || dynamic->hash[0] == 0)
+    {
+        return 0;
+    }
+
+    uint32_t total_buckets = dynamic->hash[0];
+    uint32_t total_symbols = dynamic->hash[1];
+    uint32_t* buckets = &dynamic->hash[2];
+    uint32_t* chains = &buckets[total_buckets];
+
+    // A chain is never longer than the symbol table, a broken one does not loop forever
+    uint32_t index = buckets[hash % total_buckets];
+    for (uint32_t steps = 0; index != 0 && index < total_symbols && steps < total_symbols; steps++, index = chains[index])
+    {
+        struct elf32_sym* symbol = &dynamic->symbols[index];
+        if (symbol->st_shndx == SHN_UNDEF || ELF32_ST_BIND(symbol->st_info) == STB_LOCAL)
+        {
+            continue;
+        }
+
+        const char* symbol_name = elf_link_string(file, symbol->st_name);
+        if (symbol_name && strncmp(symbol_name, name, dynamic->strings_size) == 0)
+        {
+            return symbol;
+        }
+    }
+
+    return 0;
+}
+
+/** @brief find the definition of 'name' in the program, unless 'search_program' is false, and
+ * then in its libraries */
+static int elf_link_lookup(struct elf_file* program, const char* name, bool search_program, struct elf_link_symbol* found)
+{
+    uint32_t hash = elf_link_hash(name);
+    if (search_program)
+    {
+        found->symbol = elf_link_find(program, name, hash);
+        if (found->symbol)
+        {
+            found->file = program;
+            return 0;
+        }
+    }
+
+    for (int i = 0; i < program->total_libraries; i++)
+    {
+        found->symbol = elf_link_find(program->libraries[i], name, hash);
+        if (found->symbol)
+        {
+            found->file = program->libraries[i];
+            return 0;
+        }
+    }
+
+    return -EINFORMAT;
+}
+
+/** @brief where the symbol is mapped in the process */
+static uint32_t elf_link_address(struct elf_link_symbol* found)
+{
+    if (!found->file)
+    {
+        return 0;
+    }
+
+    return found->file->load_bias + found->symbol->st_value;
+}
+
+/** @brief find the symbol 'index' of 'file' refers to. A copy relocation copies the data of
+ * a library into the program, so the program is not searched for it */
+static int elf_link_resolve(struct elf_file* program, struct elf_file* file, uint32_t index, bool copy, struct elf_link_symbol* found)
+{
+    if (index >= elf_link_symbol_count(file))
+    {
+        return -EINFORMAT;
+    }
+
+    struct elf32_sym* symbol = &file->dynamic.symbols[index];
+    if (ELF32_ST_BIND(symbol->st_info) == STB_LOCAL)
+    {
+        found->file = file;
+        found->symbol = symbol;
+        return 0;
+    }
+
+    const char* name = elf_link_string(file, symbol->st_name);
+    if (!name)
+    {
+        return -EINFORMAT;
+    }
+
+    int res = elf_link_lookup(program, name, !copy, found);
+    if (res < 0 && ELF32_ST_BIND(symbol->st_info) == STB_WEAK)
+    {
+        // An undefined weak symbol is zero
+        found->file = 0;
+        found->symbol = 0;
+        res = 0;
+    }
+
+    return res;
+}
+
+/** @brief copy the data of a library the program refers to into the program */
+static int elf_link_copy(struct elf_file* file, struct elf32_rel* relocation, struct elf_link_symbol* found)
+{
+    if (!found->file)
+    {
+        return -EINFORMAT;
+    }
+
+    uint32_t size = found->symbol->st_size;
+    void* source = elf_file_memory(found->file, found->symbol->st_value, size);
+    void* destination = elf_link_writable(file, relocation->r_offset, size);
+    if (!source || !destination)
+    {
+        return -EINFORMAT;
+    }
+
+    memcpy(destination, source, size);
+    return 0;
+}
+
+/** @brief apply 'relocation' of 'file', a function of the PLT is left to the lazy binding if
+ * 'lazy' is true. Only the writable segments are patched.
+*/
+static int elf_link_relocate(struct elf_file* program, struct elf_file* file, struct elf32_rel* relocation, bool lazy)
+{
+    int res = 0;
+    uint32_t type = ELF32_R_TYPE(relocation->r_info);
+    if (type == R_386_NONE)
+    {
+        return 0;
+    }
+
+    uint32_t* where = elf_link_writable(file, relocation->r_offset, sizeof(uint32_t));
+    if (!where)
+    {
+        return -EINFORMAT;
+    }
+
+    struct elf_link_symbol found = {};
+    uint32_t index = ELF32_R_SYM(relocation->r_info);
+    if (index != 0 && !(type == R_386_JMP_SLOT && lazy))
+    {
+        res = elf_link_resolve(program, file, index, type == R_386_COPY, &found);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    uint32_t value = elf_link_address(&found);
+    switch (type)
+    {
+        case R_386_32:
+            *where += value;
+        break;
+
+        case R_386_PC32:
+            *where += value - (file->load_bias + relocation->r_offset);
+        break;
+
+        case R_386_GLOB_DAT:
+            *where = value;
+        break;
+
+        case R_386_JMP_SLOT:
+            // Until it is bound the entry points back into the PLT, which enters the resolver
+            *where = lazy ? *where + file->load_bias : value;
+        break;
+
+        case R_386_RELATIVE:
+            *where += file->load_bias;
+        break;
+
+        case R_386_COPY:
+            res = elf_link_copy(file, relocation, &found);
+        break;
+
+        default:
+            res = -EINFORMAT;
+    }
+
+    return res;
+}
+
+/** @brief apply the relocations of 'file', it is the file 'index' of the program. The
+ * functions of its PLT are bound by 'resolver' when they are first called unless it is zero
+*/
+static int elf_link_relocate_file(struct elf_file* program, struct elf_file* file, int index, uint32_t resolver)
+{
+    int res = 0;
+    struct elf_dynamic* dynamic = &file->dynamic;
+    for (uint32_t i = 0; i < dynamic->relocations_size / sizeof(struct elf32_rel); i++)
+    {
+        res = elf_link_relocate(program, file, &dynamic->relocations[i], false);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    bool lazy = resolver != 0 && dynamic->plt_got != 0;
+    for (uint32_t i = 0; i < dynamic->plt_relocations_size / sizeof(struct elf32_rel); i++)
+    {
+        res = elf_link_relocate(program, file, &dynamic->plt_relocations[i], lazy);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    // The PLT pushes GOT[1] and jumps to GOT[2]
+    if (lazy)
+    {
+        dynamic->plt_got[1] = index;
+        dynamic->plt_got[2] = resolver;
+    }
+
+    return 0;
+}
+
+/** @brief find the dynamic section of the file and the tables it points to, the file is
+ * statically linked if it has none */
+static int elf_link_read_dynamic(struct elf_file* file)
+{
+    struct elf_header* header = elf_header(file);
+    struct elf32_phdr* phdr = 0;
+    for (int i = 0; i < header->e_phnum; i++)
+    {
+        if (elf_program_header(header, i)->p_type == PT_DYNAMIC)
+        {
+            phdr = elf_program_header(header, i);
+            break;
+        }
+    }
+
+    if (!phdr)
+    {
+        return 0;
+    }
+
+    struct elf32_dyn* entries = elf_file_memory(file, phdr->p_vaddr, phdr->p_filesz);
+    if (!entries)
+    {
+        return -EINFORMAT;
+    }
+
+    // The tags we take are all below DT_JMPREL, the others are ignored
+    uint32_t values[DT_JMPREL + 1] = {};
+    struct elf_dynamic* dynamic = &file->dynamic;
+    for (uint32_t i = 0; i < phdr->p_filesz / sizeof(struct elf32_dyn) && entries[i].d_tag != DT_NULL; i++)
+    {
+        elf32_sword tag = entries[i].d_tag;
+        switch (tag)
+        {
+            case DT_NEEDED:
+                if (dynamic->total_needed >= ELF_MAX_LIBRARIES)
+                {
+                    return -EINFORMAT;
+                }
+                dynamic->needed[dynamic->total_needed++] = entries[i].d_un.d_val;
+            break;
+
+            // The text would have to be patched, it could not be shared
+            case DT_TEXTREL:
+            case DT_RELA:
+                return -EINFORMAT;
+
+            default:
+                if (tag >= 0 && tag <= DT_JMPREL)
+                {
+                    values[tag] = entries[i].d_un.d_val;
+                }
+        }
+    }
+
+    if ((values[DT_SYMENT] && values[DT_SYMENT] != sizeof(struct elf32_sym)) ||
+        (values[DT_RELENT] && values[DT_RELENT] != sizeof(struct elf32_rel)) ||
+        (values[DT_PLTREL] && values[DT_PLTREL] != DT_REL))
+    {
+        return -EINFORMAT;
+    }
+
+    // The number of symbols is the number of chains of the hash table
+    dynamic->hash = elf_file_memory(file, values[DT_HASH], 2 * sizeof(uint32_t));
+    if (!dynamic->hash || dynamic->hash[0] >= 0x10000000 || dynamic->hash[1] >= 0x10000000)
+    {
+        return -EINFORMAT;
+    }
+
+    uint32_t total_buckets = dynamic->hash[0];
+    uint32_t total_symbols = dynamic->hash[1];
+    dynamic->hash = elf_file_memory(file, values[DT_HASH], (2 + total_buckets + total_symbols) * sizeof(uint32_t));
+    dynamic->symbols = elf_file_memory(file, values[DT_SYMTAB], total_symbols * sizeof(struct elf32_sym));
+    dynamic->strings = elf_file_memory(file, values[DT_STRTAB], values[DT_STRSZ]);
+    dynamic->strings_size = values[DT_STRSZ];
+    if (!dynamic->hash || !dynamic->symbols || !dynamic->strings)
+    {
+        return -EINFORMAT;
+    }
+
+    if (values[DT_RELSZ])
+    {
+        dynamic->relocations = elf_file_memory(file, values[DT_REL], values[DT_RELSZ]);
+        dynamic->relocations_size = values[DT_RELSZ];
+    }
+
+    if (values[DT_PLTRELSZ])
+    {
+        dynamic->plt_relocations = elf_file_memory(file, values[DT_JMPREL], values[DT_PLTRELSZ]);
+        dynamic->plt_relocations_size = values[DT_PLTRELSZ];
+    }
+
+    // GOT[0] is the dynamic section, GOT[1] and GOT[2] are for the lazy binding
+    if (values[DT_PLTGOT])
+    {
+        dynamic->plt_got = elf_link_writable(file, values[DT_PLTGOT], 3 * sizeof(uint32_t));
+        if (!dynamic->plt_got)
+        {
+            return -EINFORMAT;
+        }
+    }
+
+    if ((values[DT_RELSZ] && !dynamic->relocations) || (values[DT_PLTRELSZ] && !dynamic->plt_relocations))
+    {
+        return -EINFORMAT;
+    }
+
+    return 0;
+}
+
+/** @brief load the shared library 'name' the program needs, it is closed with the program */
+static int elf_link_load_library(struct elf_file* program, const char* name)
+{
+    char path[MAEROS_MAX_PATH];
+    int prefix = strlen(MAEROS_SHARED_LIBRARY_PATH);
+    if (prefix + strlen(name) >= sizeof(path))
+    {
+        return -EBADPATH;
+    }
+
+    strcpy(path, MAEROS_SHARED_LIBRARY_PATH);
+    strcpy(path + prefix, name);
+
+    struct elf_file* library = 0;
+    int res = elf_load(path, &library);
+    if (res < 0)
+    {
+        return res;
+    }
+
+    int index = program->total_libraries;
+    program->libraries[program->total_libraries++] = library;
+    if (elf_header(library)->e_type != ET_DYN)
+    {
+        return -EINFORMAT;
+    }
+
+    // Every library has an address space of its own
+    for (int i = 0; i < library->total_segments; i++)
+    {
+        struct elf_segment* segment = &library->segments[i];
+        if ((uint32_t) segment->virtual_address + segment->size > MAEROS_SHARED_LIBRARY_MAX_SIZE)
+        {
+            return -EINFORMAT;
+        }
+    }
+
+    library->load_bias = MAEROS_SHARED_LIBRARY_VIRTUAL_ADDRESS + index * MAEROS_SHARED_LIBRARY_MAX_SIZE;
+    return elf_link_read_dynamic(library);
+}
+
+int elf_link(struct elf_file* program)
+{
+    int res = elf_link_read_dynamic(program);
+    if (res < 0 || !program->dynamic.symbols)
+    {
+        return res;
+    }
+
+    for (int i = 0; i < program->dynamic.total_needed; i++)
+    {
+        const char* name = elf_link_string(program, program->dynamic.needed[i]);
+        if (!name)
+        {
+            return -EINFORMAT;
+        }
+
+        res = elf_link_load_library(program, name);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    // The functions are bound right away if no library has the stub of the lazy binding
+    uint32_t resolver = 0;
+#if MAEROS_ELF_LAZY_BINDING
+    struct elf_link_symbol found;
+    if (elf_link_lookup(program, ELF_LINK_RESOLVER, false, &found) == 0)
+    {
+        resolver = elf_link_address(&found);
+    }
+#endif
+
+    // The libraries go first, the program copies their data once it is relocated
+    for (int i = 0; i < program->total_libraries; i++)
+    {
+        res = elf_link_relocate_file(program, program->libraries[i], i + 1, resolver);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    return elf_link_relocate_file(program, program, 0, resolver);
+}
+
+void* elf_link_bind(struct elf_file* program, int index, uint32_t offset)
+{
+    if (index < 0 || index > program->total_libraries)
+    {
+        return 0;
+    }
+
+    struct elf_file* file = index == 0 ? program : program->libraries[index - 1];
+    struct elf_dynamic* dynamic = &file->dynamic;
+    if (offset % sizeof(struct elf32_rel) != 0 || offset >= dynamic->plt_relocations_size)
+    {
+        return 0;
+    }
+
+    struct elf32_rel* relocation = &dynamic->plt_relocations[offset / sizeof(struct elf32_rel)];
+    if (ELF32_R_TYPE(relocation->r_info) != R_386_JMP_SLOT || elf_link_relocate(program, file, relocation, false) < 0)
+    {
+        return 0;
+    }
+
+    uint32_t* where = elf_link_writable(file, relocation->r_offset, sizeof(uint32_t));
+    return (void*) *where;
+}
@@ -0,0 +1,46 @@
+#ifndef ELFLINK_H
+#define ELFLINK_H
+
+#include <stdint.h>
+#include "elfloader.h"
+
+/** @file elflink.h
+ * @brief Dynamic linking of a program against the shared libraries (ET_DYN) it needs. There
+ * is no dynamic linker in user land, the kernel links the program when it loads it.
+ *
+ * A library is loaded through the image cache like a program, so the pages of its read-only
+ * segments (the text) are shared by every process using it and each process gets a copy of
+ * its writable segments. A library is mapped at MAEROS_SHARED_LIBRARY_VIRTUAL_ADDRESS plus
+ * MAEROS_SHARED_LIBRARY_MAX_SIZE times its position in the DT_NEEDED list of the program.
+ * It is compiled position independent and only its writable segments are relocated, a
+ * library with text relocations is refused since its text could not be shared.
+ *
+ * A symbol is looked up in the program first and then in the libraries in DT_NEEDED order,
+ * so the copy a R_386_COPY relocation makes in the program is the one the library uses too.
+ *
+ * The functions a program calls through its PLT are bound lazily: the GOT entry of a function
+ * initially points back into the PLT, which pushes the relocation offset and jumps to GOT[2]
+ * with GOT[1] pushed too. GOT[1] is the index of the file (0 for the program, 1 + n for the
+ * library n) and GOT[2] is ELF_LINK_RESOLVER, a stub of the library entering the kernel with
+ * both of them. The kernel writes the address of the function to the GOT entry (see
+ * elf_link_bind), so the next call goes straight to the function. If no library has the stub
+ * or MAEROS_ELF_LAZY_BINDING is 0, every function is bound at load time.
+*/
+
+/** @brief the stub a library has for the lazy binding, it takes the file index and the
+ * relocation offset the PLT pushed, enters the kernel and jumps to the function */
+#define ELF_LINK_RESOLVER "maeros_dl_resolve"
+
+/** @brief load the shared libraries 'program' needs and relocate them and the program. A
+ * program without a dynamic section is statically linked, there is nothing to do.
+ * @retval 0 on success, -EINFORMAT if a symbol is missing or a relocation is not supported
+*/
+int elf_link(struct elf_file* program);
+
+/** @brief bind the PLT entry of the file 'index' whose relocation is 'offset' bytes into
+ * DT_JMPREL, i.e. write the address of the function to its GOT entry
+ * @retval the address of the function, or null if it cannot be bound
+*/
+void* elf_link_bind(struct elf_file* program, int index, uint32_t offset);
+
+#endif
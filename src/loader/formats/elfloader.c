@@ -8,6 +8,7 @@
 #include "memory/paging/paging.h"
 #include "kernel.h"
 #include "config.h"
+#include "elfcache.h"
 
 /** @brief it is the signature, The initial bytes of an ELF header (and an object file) 
  * correspond to identification number (e_ident field )*/
@@ -94,10 +95,16 @@ struct elf32_shdr* elf_section(struct elf_header* header, int index)
     return &elf_sheader(header)[index];
 }
 
-/** @brief Return program header physical address */
+/** @brief Return program header physical address, the first byte of its segment in memory */
 void* elf_phdr_phys_address(struct elf_file* file, struct elf32_phdr* phdr)
 {
-    return elf_memory(file) + phdr->p_offset;
+    struct elf_segment* segment = elf_segment(file, phdr);
+    if (!segment)
+    {
+        return 0;
+    }
+
+    return segment->memory + (phdr->p_vaddr - (uint32_t) segment->virtual_address);
 }
 
 /** @brief Return string table */
@@ -147,14 +154,14 @@ int elf_process_phdr_pt_load(struct elf_file* elf_file, struct elf32_phdr* phdr)
     if (elf_file->virtual_base_address >= (void*) phdr->p_vaddr || elf_file->virtual_base_address == 0x00)
     {
         elf_file->virtual_base_address = (void*) phdr->p_vaddr;
-        elf_file->physical_base_address = elf_memory(elf_file)+phdr->p_offset;
+        elf_file->physical_base_address = elf_phdr_phys_address(elf_file, phdr);
     }
 
     unsigned int end_virtual_address = phdr->p_vaddr + phdr->p_filesz;
     if (elf_file->virtual_end_address <= (void*)(end_virtual_address) || elf_file->virtual_end_address == 0x00)
     {
         elf_file->virtual_end_address = (void*) end_virtual_address;
-        elf_file->physical_end_address = elf_memory(elf_file)+phdr->p_offset+phdr->p_filesz;
+        elf_file->physical_end_address = elf_phdr_phys_address(elf_file, phdr)+phdr->p_filesz;
     } 
     return 0;
 }
@@ -214,35 +221,97 @@ out:
 }
 
 
+struct elf_segment* elf_segment(struct elf_file* file, struct elf32_phdr* phdr)
+{
+    for (int i = 0; i < file->total_segments; i++)
+    {
+        if (file->segments[i].phdr == phdr)
+        {
+            return &file->segments[i];
+        }
+    }
+
+    return 0;
+}
+
+void* elf_file_memory(struct elf_file* file, uint32_t address, uint32_t size)
+{
+    for (int i = 0; i < file->total_segments; i++)
+    {
+        struct elf_segment* segment = &file->segments[i];
+        uint32_t start = (uint32_t) segment->virtual_address;
+        if (address >= start && size <= segment->size && address - start <= segment->size - size)
+        {
+            return segment->memory + (address - start);
+        }
+    }
+
+    return 0;
+}
+
+/** @brief take the segments of the image, the process gets a copy of the writable ones */
+static int elf_load_segments(struct elf_file* elf_file)
+{
+    struct elf_image* image = elf_file->image;
+    for (int i = 0; i < image->total_segments; i++)
+    {
+        struct elf_segment* segment = &elf_file->segments[i];
+        *segment = image->segments[i];
+        elf_file->total_segments++;
+        if (!(segment->phdr->p_flags & PF_W))
+        {
+            continue;
+        }
+
+        segment->memory = kzalloc(segment->size);
+        if (!segment->memory && elf_cache_shrink() > 0)
+        {
+            segment->memory = kzalloc(segment->size);
+        }
+
+        if (!segment->memory)
+        {
+            // Nothing of the image is freed with the file
+            elf_file->total_segments--;
+            return -ENOMEM;
+        }
+
+        memcpy(segment->memory, image->segments[i].memory, segment->size);
+    }
+
+    return 0;
+}
+
 int elf_load(const char* filename, struct elf_file** file_out)
 {
+    int res = 0;
     /* allocate memory for this elf file */
     struct elf_file* elf_file = kzalloc(sizeof(struct elf_file));
-    int fd = 0;
-    int res = fopen(filename, "r");
-    if (res <= 0)
+    if (!elf_file)
     {
-        res = -EIO;
+        res = -ENOMEM;
         goto out;
     }
 
-    fd = res;
-    struct file_stat stat;
-    res = fstat(fd, &stat);
+    /* the headers and the segments, they are read from the disk only if they are not cached */
+    res = elf_cache_get(filename, &elf_file->image);
     if (res < 0)
     {
         goto out;
     }
 
-    elf_file->elf_memory = kzalloc(stat.filesize);
-    /* read entire file into memory */
-    res = fread(elf_file->elf_memory, stat.filesize, 1, fd);
+    elf_file->elf_memory = elf_file->image->memory;
+    strncpy(elf_file->filename, filename, sizeof(elf_file->filename));
+
+    /* the process writes its data, it gets a copy of its own */
+    res = elf_load_segments(elf_file);
     if (res < 0)
     {
         goto out;
     }
 
-    res = elf_process_loaded(elf_file);
+    // The image is validated when it is read, the program headers are left
+    res = elf_process_pheaders(elf_file);
     if(res < 0)
     {
         goto out;
@@ -250,7 +319,10 @@ int elf_load(const char* filename, struct elf_file** file_out)
 
     *file_out = elf_file;
 out:
-    fclose(fd);
+    if (res < 0)
+    {
+        elf_close(elf_file);
+    }
     return res;
 }
 
@@ -259,6 +331,18 @@ void elf_close(struct elf_file* file)
     if (!file)
         return;
 
-    kfree(file->elf_memory);
+    for (int i = 0; i < file->total_libraries; i++)
+    {
+        elf_close(file->libraries[i]);
+    }
+
+    for (int i = 0; i < file->total_segments; i++)
+    {
+        if (file->segments[i].phdr->p_flags & PF_W)
+        {
+            kfree(file->segments[i].memory);
+        }
+    }
+    elf_cache_put(file->image);
     kfree(file);
-}
\ No newline at end of file
+}
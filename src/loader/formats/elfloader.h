@@ -7,6 +7,57 @@
 #include "elf.h"
 #include "config.h"
 
+struct elf_image;
+
+/** @brief number of PT_LOAD segments a program may have */
+#define ELF_MAX_SEGMENTS 8
+
+/** @brief a PT_LOAD segment in memory, it covers whole pages. The bytes of the pages the file
+ * does not cover (i.e. .bss) are zero */
+struct elf_segment
+{
+    /** @brief the program header of the segment */
+    struct elf32_phdr* phdr;
+
+    /** @brief the page aligned virtual address of the segment */
+    void* virtual_address;
+
+    /** @brief the page aligned physical memory of the segment and its size */
+    void* memory;
+    uint32_t size;
+};
+
+/** @brief number of shared libraries a program may need (DT_NEEDED) */
+#define ELF_MAX_LIBRARIES 4
+
+/** @brief the dynamic section of a program or a shared library, what the kernel links it
+ * with (see elflink.h). The pointers are kernel addresses of the loaded segments. */
+struct elf_dynamic
+{
+    /** @brief the symbol table and the names of the symbols (DT_SYMTAB, DT_STRTAB) */
+    struct elf32_sym* symbols;
+    const char* strings;
+    uint32_t strings_size;
+
+    /** @brief the symbol hash table (DT_HASH), nbucket and nchain followed by the buckets
+     * and the chains. nchain is the number of symbols */
+    uint32_t* hash;
+
+    /** @brief the relocations applied at load time (DT_REL) and the ones of the PLT
+     * (DT_JMPREL), the sizes are in bytes */
+    struct elf32_rel* relocations;
+    uint32_t relocations_size;
+    struct elf32_rel* plt_relocations;
+    uint32_t plt_relocations_size;
+
+    /** @brief the GOT of the PLT (DT_PLTGOT), it is in the copy of the process */
+    uint32_t* plt_got;
+
+    /** @brief the names of the needed libraries, offsets in the strings (DT_NEEDED) */
+    uint32_t needed[ELF_MAX_LIBRARIES];
+    int total_needed;
+};
+
 /** @brief elf file structure*/
 struct elf_file
 {
@@ -16,12 +67,32 @@ struct elf_file
     /** @brief the size of this elf file when it's loaded into memory */
     int in_memory_size;
 
+    /** @brief the cached file the memory is copied from, referenced until elf_close */
+    struct elf_image* image;
+
     /**
-     * @brief The physical memory address that this elf file is loaded at
-     * whole .elf file loaded into memory
+     * @brief The ELF header followed by the program headers, the section headers and the
+     * other non-loadable parts of the file are not read. It belongs to the cached image
+     * shared by every process running the program, so it is read-only.
      */
     void* elf_memory;
 
+    /** @brief the PT_LOAD segments, a read-only one is the one of the image every process
+     * running the program maps, a writable one is a copy of this process */
+    struct elf_segment segments[ELF_MAX_SEGMENTS];
+    int total_segments;
+
+    /** @brief what is added to the addresses of the file to get where it is mapped, zero
+     * but for a shared library */
+    uint32_t load_bias;
+
+    /** @brief the dynamic section, no symbols if the file is not dynamically linked */
+    struct elf_dynamic dynamic;
+
+    /** @brief the shared libraries the program is linked with, they are closed with it */
+    struct elf_file* libraries[ELF_MAX_LIBRARIES];
+    int total_libraries;
+
     /**
      * @brief The virtual base address of this binary, 
      * the virtual base address will point to the first loadable section in memory.
@@ -52,6 +123,10 @@ int elf_load(const char* filename, struct elf_file** file_out);
 
 /** @brief Free the elf file and memory allocated for it */
 void elf_close(struct elf_file* file);
+/** @brief check the ELF header of a file in memory
+ * @retval MAEROS_ALL_OK if it is an ELF file we can run, -EINFORMAT otherwise
+*/
+int elf_validate_loaded(struct elf_header* header);
 void* elf_virtual_base(struct elf_file* file);
 void* elf_virtual_end(struct elf_file* file);
 void* elf_phys_base(struct elf_file* file);
@@ -64,5 +139,10 @@ struct elf32_phdr* elf_pheader(struct elf_header* header);
 struct elf32_phdr* elf_program_header(struct elf_header* header, int index);
 struct elf32_shdr* elf_section(struct elf_header* header, int index);
 void* elf_phdr_phys_address(struct elf_file* file, struct elf32_phdr* phdr);
+/** @brief the loaded segment of program header 'phdr', or null if it is not a PT_LOAD one */
+struct elf_segment* elf_segment(struct elf_file* file, struct elf32_phdr* phdr);
+/** @brief the memory of 'size' bytes at address 'address' of the file (without the load bias),
+ * or null unless a single loaded segment covers them */
+void* elf_file_memory(struct elf_file* file, uint32_t address, uint32_t size);
 
 #endif
\ No newline at end of file
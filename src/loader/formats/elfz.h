@@ -0,0 +1,44 @@
+#ifndef ELFZ_H
+#define ELFZ_H
+
+#include <stdint.h>
+
+/** @file elfz.h
+ * @brief A container holding an ELF executable with its PT_LOAD segments compressed as LZ4
+ * blocks, so starting a program reads fewer sectors. tools/elfz.c builds it from an ELF
+ * file and the loader (see elfcache.c) takes either of them. The layout is:
+ *
+ *  struct elfz_header
+ *  struct elf_header, as in the ELF file
+ *  struct elf32_phdr[e_phnum], as in the ELF file, p_offset is not used
+ *  struct elfz_segment[e_phnum], where the data of each program header is in the container
+ *  the LZ4 blocks, one per PT_LOAD segment holding its p_filesz bytes
+ *
+ * The header is shared with the host tool, it has nothing but the format.
+*/
+
+/** @brief the first bytes of the container, an ELF file starts with 0x7f 'E' 'L' 'F' */
+#define ELFZ_MAGIC0 0x7f
+#define ELFZ_MAGIC1 'E'
+#define ELFZ_MAGIC2 'L'
+#define ELFZ_MAGIC3 'Z'
+
+#define ELFZ_VERSION 1
+
+struct elfz_header
+{
+    uint8_t magic[4];
+    uint32_t version;
+    /** @brief size of the ELF file the container is made of */
+    uint32_t elf_size;
+    uint32_t reserved;
+} __attribute__((packed));
+
+struct elfz_segment
+{
+    /** @brief offset of the LZ4 block in the container, zero if the program header has no data */
+    uint32_t offset;
+    uint32_t compressed_size;
+} __attribute__((packed));
+
+#endif
@@ -0,0 +1,135 @@
+#include "lz4.h"
+#include "fs/file.h"
+#include "status.h"
+#include <stdbool.h>
+
+/** @brief the compressed bytes not consumed yet */
+struct lz4_source
+{
+    int fd;
+    /** @brief bytes of the block still in the file */
+    uint32_t remaining;
+    uint8_t buffer[LZ4_SOURCE_BUFFER_SIZE];
+    uint32_t position;
+    uint32_t length;
+    /** @brief -EIO if a read failed, -EINFORMAT if the block ended in the middle of a sequence */
+    int error;
+};
+
+static bool lz4_source_empty(struct lz4_source* source)
+{
+    return source->position == source->length && source->remaining == 0;
+}
+
+static uint8_t lz4_source_byte(struct lz4_source* source)
+{
+    if (source->error)
+    {
+        return 0;
+    }
+
+    if (source->position == source->length)
+    {
+        uint32_t length = source->remaining < LZ4_SOURCE_BUFFER_SIZE ? source->remaining : LZ4_SOURCE_BUFFER_SIZE;
+        if (length == 0)
+        {
+            source->error = -EINFORMAT;
+            return 0;
+        }
+
+        // Anything but the whole chunk, i.e. a file shorter than its headers say, is an error
+        if (fread(source->buffer, length, 1, source->fd) != 1)
+        {
+            source->error = -EIO;
+            return 0;
+        }
+
+        source->remaining -= length;
+        source->position = 0;
+        source->length = length;
+    }
+
+    return source->buffer[source->position++];
+}
+
+/** @brief a literal or a match length, 15 in the token means more bytes follow and each
+ * byte of 255 means yet another one */
+static uint32_t lz4_source_length(struct lz4_source* source, uint32_t length)
+{
+    if (length != 15)
+    {
+        return length;
+    }
+
+    uint8_t byte;
+    do
+    {
+        byte = lz4_source_byte(source);
+        length += byte;
+    } while (byte == 255 && !source->error);
+
+    return length;
+}
+
+int lz4_decompress_file(int fd, uint32_t compressed_size, void* out, uint32_t out_size)
+{
+    struct lz4_source source = {};
+    source.fd = fd;
+    source.remaining = compressed_size;
+
+    uint8_t* dst = out;
+    uint32_t written = 0;
+    while (!lz4_source_empty(&source))
+    {
+        uint8_t token = lz4_source_byte(&source);
+
+        // The literals are copied as they are
+        uint32_t literals = lz4_source_length(&source, token >> 4);
+        if (source.error)
+        {
+            return source.error;
+        }
+
+        if (literals > out_size - written)
+        {
+            return -EINFORMAT;
+        }
+
+        for (uint32_t i = 0; i < literals; i++)
+        {
+            dst[written++] = lz4_source_byte(&source);
+        }
+
+        if (source.error)
+        {
+            return source.error;
+        }
+
+        // The last sequence has no match
+        if (lz4_source_empty(&source))
+        {
+            break;
+        }
+
+        uint32_t offset = lz4_source_byte(&source);
+        offset |= (uint32_t) lz4_source_byte(&source) << 8;
+        uint32_t match = lz4_source_length(&source, token & 0x0f) + 4;
+        if (source.error)
+        {
+            return source.error;
+        }
+
+        if (offset == 0 || offset > written || match > out_size - written)
+        {
+            return -EINFORMAT;
+        }
+
+        // The match may overlap what it writes, it is copied a byte at a time
+        for (uint32_t i = 0; i < match; i++, written++)
+        {
+            dst[written] = dst[written - offset];
+        }
+    }
+
+    return source.error ? source.error : (int) written;
+}
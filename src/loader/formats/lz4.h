@@ -0,0 +1,22 @@
+#ifndef LZ4_H
+#define LZ4_H
+
+#include <stdint.h>
+
+/** @file lz4.h
+ * @brief LZ4 block decompression straight from a file. The compressed bytes are read a
+ * sector at a time while the data is written to its destination, the block is never held
+ * in memory as a whole.
+*/
+
+/** @brief the compressed bytes read from the file at once */
+#define LZ4_SOURCE_BUFFER_SIZE 512
+
+/** @brief decompress the LZ4 block of 'compressed_size' bytes at the position of file 'fd'
+ * into 'out', which holds 'out_size' bytes
+ * @retval number of bytes written to 'out', -EINFORMAT if the block is corrupt, or -EIO if the
+ * file ends before the block does. The caller checks that the block is inside the file.
+*/
+int lz4_decompress_file(int fd, uint32_t compressed_size, void* out, uint32_t out_size);
+
+#endif
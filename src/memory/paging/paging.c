@@ -1,6 +1,8 @@
 #include "paging.h"
 #include "memory/heap/kheap.h"
 #include "status.h"
+#include "config.h"
+#include "task/task.h"
 
 /** @brief */
 void paging_load_directory(uint32_t *directory);
@@ -27,6 +29,13 @@ struct paging_4gb_chunk *paging_new_4gb(uint8_t flags)
         /* offset is incremented by the amount of table */
         offset += (PAGING_TOTAL_ENTRIES_PER_TABLE * PAGING_PAGE_SIZE);
         directory[i] = (uint32_t)entry | flags | PAGING_IS_WRITEABLE;
+
+        /* filling 4MB of tables takes a while (i.e. loading a process), let the other
+        tasks run in between */
+        if ((i + 1) % MAEROS_PAGING_PREEMPT_TABLES == 0)
+        {
+            task_preempt_point();
+        }
     }
 
     /* Return the chunk structure which points to the first directory */
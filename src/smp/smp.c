@@ -0,0 +1,270 @@
+#include "smp.h"
+#include "spinlock.h"
+#include "kernel.h"
+#include "status.h"
+#include "apic/lapic.h"
+#include "apic/madt.h"
+#include "idt/idt.h"
+#include "isr80h/sysenter.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+#include "timer/clock.h"
+#include "timer/timer.h"
+#include "task/fpu.h"
+
+/** @brief The CPUs, the first one is the BSP */
+static struct cpu cpus[MAEROS_MAX_CPUS] = {
+    [0] = {.id = 0, .started = true}
+};
+
+/** @brief number of CPUs found, it stays one if the machine has no MADT */
+static int smp_total_cpus = 1;
+
+/** @brief CPU lookup by the local APIC ID, the ID is the only thing a CPU knows about itself */
+static struct cpu* cpu_by_apic_id[256];
+
+/** @brief the big kernel lock, see smp.h */
+static struct spinlock kernel_big_lock = {};
+
+/** @brief the real mode trampoline and its slots (see trampoline.asm) */
+extern uint8_t smp_trampoline_start[];
+extern uint8_t smp_trampoline_end[];
+extern uint32_t smp_trampoline_stack;
+extern uint32_t smp_trampoline_cr3;
+extern uint32_t smp_trampoline_entry;
+
+struct cpu* cpu_current()
+{
+    if (smp_total_cpus == 1)
+    {
+        return &cpus[0];
+    }
+
+    return cpu_by_apic_id[lapic_id()];
+}
+
+struct cpu* cpu_get(int index)
+{
+    if (index < 0 || index >= smp_total_cpus)
+    {
+        return 0;
+    }
+
+    return &cpus[index];
+}
+
+int smp_cpu_count()
+{
+    return smp_total_cpus;
+}
+
+void cpu_init(struct cpu* cpu)
+{
+    struct gdt_structured gdt_structured[MAEROS_TOTAL_GDT_SEGMENTS] = {
+        {.base = 0x00, .limit = 0x00, .type = 0x00},                           // NULL Segment
+        {.base = 0x00, .limit = 0xffffffff, .type = 0x9a},                     // Kernel code segment
+        {.base = 0x00, .limit = 0xffffffff, .type = 0x92},                     // Kernel data segment
+        {.base = 0x00, .limit = 0xffffffff, .type = 0xf8},                     // User code segment
+        {.base = 0x00, .limit = 0xffffffff, .type = 0xf2},                     // User data segment
+        {.base = (uint32_t)&cpu->tss, .limit = sizeof(cpu->tss), .type = 0xE9}, // TSS Segment
+        {.base = 0x00, .limit = 0xffffffff, .type = 0xf2}                      // User TLS segment
+    };
+
+    memset(cpu->gdt, 0x00, sizeof(cpu->gdt));
+    gdt_structured_to_gdt(cpu->gdt, gdt_structured, MAEROS_TOTAL_GDT_SEGMENTS);
+    gdt_load(cpu->gdt, sizeof(cpu->gdt));
+
+    memset(&cpu->tss, 0x00, sizeof(cpu->tss));
+    cpu->tss.esp0 = 0x600000;    //where kernel stack is located until the first task runs
+    cpu->tss.ss0 = KERNEL_DATA_SELECTOR;
+
+    // 0x28 is the offset of the TSS segment in the GDT
+    tss_load(0x28);
+
+    // System calls through SYSENTER start on the TSS
+    sysenter_init(cpu);
+}
+
+void cpu_set_tls_base(struct cpu* cpu, uint32_t base)
+{
+    gdt_set_base(&cpu->gdt[USER_TLS_SEGMENT >> 3], base);
+}
+
+void kernel_lock()
+{
+    struct cpu* cpu = cpu_current();
+    if (cpu->kernel_lock_depth++ == 0)
+    {
+        spin_lock(&kernel_big_lock);
+    }
+}
+
+void kernel_unlock()
+{
+    struct cpu* cpu = cpu_current();
+    if (--cpu->kernel_lock_depth == 0)
+    {
+        spin_unlock(&kernel_big_lock);
+    }
+}
+
+int kernel_lock_release_all()
+{
+    struct cpu* cpu = cpu_current();
+    int depth = cpu->kernel_lock_depth;
+    if (depth)
+    {
+        cpu->kernel_lock_depth = 0;
+        spin_unlock(&kernel_big_lock);
+    }
+
+    return depth;
+}
+
+void kernel_lock_reacquire(int depth)
+{
+    if (depth)
+    {
+        spin_lock(&kernel_big_lock);
+        cpu_current()->kernel_lock_depth = depth;
+    }
+}
+
+void smp_send_reschedule(struct cpu* cpu)
+{
+    if (cpu->started && cpu != cpu_current())
+    {
+        lapic_send_ipi(cpu->apic_id, LAPIC_RESCHEDULE_VECTOR);
+    }
+}
+
+void cpu_program_timer(struct cpu* cpu, bool has_deadline, uint32_t deadline)
+{
+    // The PIT interrupt only comes to the BSP, it runs the kernel timers of every CPU
+    if (cpu->id == 0)
+    {
+        timer_program_next_event(has_deadline, deadline);
+        return;
+    }
+
+    if (!has_deadline)
+    {
+        lapic_timer_stop();
+        return;
+    }
+
+    lapic_timer_program(clock_cycles_until(deadline));
+}
+
+/** @brief the first C code an AP runs, on its boot stack with the kernel page directory */
+static void smp_ap_main()
+{
+    struct cpu* cpu = cpu_current();
+    cpu_init(cpu);
+    idt_init_ap();
+    kernel_registers();
+    lapic_enable(false, false);
+    fpu_init_ap();
+
+    cpu->started = true;
+
+    /* notice that we never return from here, the idle task runs until the scheduler
+    gives this CPU something to do */
+    kernel_lock();
+    task_run_idle();
+}
+
+/** @brief address of a trampoline slot in the copy of the trampoline */
+static uint32_t* smp_trampoline_slot(uint32_t* slot)
+{
+    return (uint32_t*)(MAEROS_SMP_TRAMPOLINE_ADDRESS + ((uint32_t) slot - (uint32_t) smp_trampoline_start));
+}
+
+/** @brief start an AP and wait until it runs the kernel
+ * @note the trampoline slots are shared, the APs are started one at a time
+*/
+static int smp_start_cpu(struct cpu* cpu)
+{
+    int res = 0;
+    task_idle_init(cpu);
+
+    cpu->boot_stack = kzalloc(MAEROS_KERNEL_STACK_SIZE);
+    if (!cpu->boot_stack)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    *smp_trampoline_slot(&smp_trampoline_stack) = (uint32_t) cpu->boot_stack + MAEROS_KERNEL_STACK_SIZE;
+    *smp_trampoline_slot(&smp_trampoline_cr3) = (uint32_t) paging_4gb_chunk_get_directory(kernel_paging_chunk());
+    *smp_trampoline_slot(&smp_trampoline_entry) = (uint32_t) smp_ap_main;
+
+    // INIT, then STARTUP twice as Intel recommends, the second one is skipped if the first worked
+    lapic_send_init(cpu->apic_id);
+    clock_delay_us(10000);
+    lapic_send_startup(cpu->apic_id, MAEROS_SMP_TRAMPOLINE_ADDRESS >> 12);
+    clock_delay_us(200);
+    if (!cpu->started)
+    {
+        lapic_send_startup(cpu->apic_id, MAEROS_SMP_TRAMPOLINE_ADDRESS >> 12);
+    }
+
+    uint32_t timeout = clock_uptime_ms() + MAEROS_SMP_START_TIMEOUT_MS;
+    while(!cpu->started && clock_uptime_ms() < timeout)
+    {
+    }
+
+    if (!cpu->started)
+    {
+        res = -EIO;
+    }
+
+out:
+    return res;
+}
+
+void smp_init()
+{
+    /* the BSP holds the big kernel lock until the first task runs, the APs wait for it
+    before they run their idle tasks */
+    kernel_lock();
+
+    // irq_init sets the local APIC of the BSP up if the machine has one
+    struct madt_info info;
+    if (!lapic_available() || madt_parse(&info) < 0 || info.total_cpus <= 1)
+    {
+        print("Single CPU \n");
+        return;
+    }
+
+    uint8_t bsp_apic_id = lapic_id();
+    cpus[0].apic_id = bsp_apic_id;
+    cpu_by_apic_id[bsp_apic_id] = &cpus[0];
+
+    int total = 1;
+    for (int i = 0; i < info.total_cpus; i++)
+    {
+        if (info.cpu_apic_ids[i] == bsp_apic_id)
+        {
+            continue;
+        }
+
+        cpus[total].id = total;
+        cpus[total].apic_id = info.cpu_apic_ids[i];
+        cpu_by_apic_id[cpus[total].apic_id] = &cpus[total];
+        total++;
+    }
+
+    // cpu_current reads the local APIC from now on
+    smp_total_cpus = total;
+
+    memcpy((void*) MAEROS_SMP_TRAMPOLINE_ADDRESS, smp_trampoline_start, smp_trampoline_end - smp_trampoline_start);
+    for (int i = 1; i < total; i++)
+    {
+        if (smp_start_cpu(&cpus[i]) < 0)
+        {
+            print("CPU failed to start \n");
+        }
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef SMP_H
+#define SMP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "config.h"
+#include "gdt/gdt.h"
+#include "task/tss.h"
+#include "task/task.h"
+
+/** @file smp.h
+ * @brief Symmetric multiprocessing. The CPUs are listed by the ACPI MADT, the bootstrap CPU
+ * (BSP) starts the others (APs) with INIT and STARTUP IPIs. Every CPU has its own GDT, TSS
+ * and run queue, the tasks move between the CPUs by work stealing.
+ *
+ * The kernel itself is protected by one big kernel lock. A CPU takes it when it enters the
+ * kernel (interrupt or syscall) and releases it when it returns to user land or halts in its
+ * idle task, so only one CPU runs kernel code at a time while user land runs on all of them.
+*/
+
+/** @brief per-CPU data */
+struct cpu
+{
+    /** @brief index in the CPU array, the BSP is zero */
+    int id;
+
+    uint8_t apic_id;
+
+    /** @brief set by the CPU itself once it runs the kernel */
+    volatile bool started;
+
+    /** @brief the GDT of the CPU, the TSS descriptor points to its own TSS */
+    struct gdt gdt[MAEROS_TOTAL_GDT_SEGMENTS];
+    struct tss tss;
+
+    /** @brief how many times the CPU has taken the big kernel lock */
+    int kernel_lock_depth;
+
+    /** @brief the last task whose FPU registers were loaded, and whether they are in use
+     * by the running task (CR0.TS is clear) */
+    struct task* fpu_owner;
+    bool fpu_active;
+
+    /** @brief the stack the CPU starts on, it is left when the CPU switches to its idle task */
+    void* boot_stack;
+
+    struct run_queue run_queue;
+};
+
+/** @brief find the CPUs and start them, they run their idle tasks until there is work for them
+ * @note it takes the big kernel lock, the BSP holds it until the first task runs
+*/
+void smp_init();
+
+/** @brief the CPU running this code */
+struct cpu* cpu_current();
+
+/** @brief the CPU at 'index', zero if there is no such CPU */
+struct cpu* cpu_get(int index);
+
+/** @brief number of CPUs found, started or not */
+int smp_cpu_count();
+
+/** @brief load the GDT and the TSS of the current CPU */
+void cpu_init(struct cpu* cpu);
+
+/** @brief point the user TLS segment of the CPU at 'base', gs picks it up when user_registers
+ * loads it on the way back to user land */
+void cpu_set_tls_base(struct cpu* cpu, uint32_t base);
+
+/** @brief make the CPU look at its run queue, i.e. a task is put into it while it is idle */
+void smp_send_reschedule(struct cpu* cpu);
+
+/** @brief program the timer interrupt of the current CPU for the next kernel timer (BSP only)
+ * or for 'deadline' (i.e. end of a time slice) */
+void cpu_program_timer(struct cpu* cpu, bool has_deadline, uint32_t deadline);
+
+/** @brief take the big kernel lock, a CPU can take it more than once */
+void kernel_lock();
+void kernel_unlock();
+
+/** @brief release the big kernel lock however many times it is taken, and take it back
+ * as many times. i.e. around the interrupt window of a preemption point */
+int kernel_lock_release_all();
+void kernel_lock_reacquire(int depth);
+
+#endif
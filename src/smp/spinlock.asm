@@ -0,0 +1,32 @@
+[BITS 32]
+section .asm
+
+global spin_lock
+global spin_unlock
+
+; void spin_lock(struct spinlock* lock);
+spin_lock:
+    mov edx, [esp+4]
+.retry:
+    mov eax, 1
+    ; xchg with a memory operand is always atomic (locked)
+    xchg eax, [edx]
+    test eax, eax
+    jz .locked
+
+    ; wait with plain reads until the lock looks free, then try again
+.spin:
+    pause
+    cmp dword [edx], 0
+    jne .spin
+    jmp .retry
+
+.locked:
+    ret
+
+; void spin_unlock(struct spinlock* lock);
+spin_unlock:
+    mov edx, [esp+4]
+    ; stores are not reordered with older stores on x86, a plain store releases the lock
+    mov dword [edx], 0
+    ret
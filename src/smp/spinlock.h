@@ -0,0 +1,18 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdint.h>
+
+/** @brief A lock other CPUs busy wait on, it is taken with an atomic exchange */
+struct spinlock
+{
+    volatile uint32_t locked;
+};
+
+/** @brief spin until the lock is taken (in asm file) */
+void spin_lock(struct spinlock* lock);
+
+/** @brief release the lock (in asm file) */
+void spin_unlock(struct spinlock* lock);
+
+#endif
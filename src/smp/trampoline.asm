@@ -0,0 +1,81 @@
+; The code the other CPUs (application processors) run when they receive the STARTUP IPI.
+; It is copied to MAEROS_SMP_TRAMPOLINE_ADDRESS (see config.h) below 1MB, the CPU starts
+; there in real mode with cs = address >> 4 and ip = 0. It switches to protected mode,
+; enables paging with the kernel page directory and calls smp_ap_main on its own stack.
+; The slots at the end are filled by smp.c in the copy before the CPU is started.
+[BITS 16]
+section .asm
+
+global smp_trampoline_start
+global smp_trampoline_end
+global smp_trampoline_stack
+global smp_trampoline_cr3
+global smp_trampoline_entry
+
+; must be equal to MAEROS_SMP_TRAMPOLINE_ADDRESS
+TRAMPOLINE_ADDRESS equ 0x70000
+
+; the address of a label in the copy of the trampoline
+%define TRAMPOLINE(label) (TRAMPOLINE_ADDRESS + (label - smp_trampoline_start))
+
+CODE_SEG equ 0x08
+DATA_SEG equ 0x10
+
+smp_trampoline_start:
+    cli
+    cld
+    mov ax, cs
+    mov ds, ax
+
+    ; the offsets are relative to the start since ds points to the copy
+    lgdt [trampoline_gdt_descriptor - smp_trampoline_start]
+
+    mov eax, cr0
+    or eax, 1
+    mov cr0, eax
+
+    ; far jump loads the 32 bit code segment
+    jmp dword CODE_SEG:TRAMPOLINE(trampoline_protected_mode)
+
+[BITS 32]
+trampoline_protected_mode:
+    mov ax, DATA_SEG
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; enable paging with the kernel page directory, the trampoline is identity mapped
+    mov eax, [TRAMPOLINE(smp_trampoline_cr3)]
+    mov cr3, eax
+    mov eax, cr0
+    or eax, 0x80000000
+    mov cr0, eax
+
+    mov esp, [TRAMPOLINE(smp_trampoline_stack)]
+    mov eax, [TRAMPOLINE(smp_trampoline_entry)]
+    call eax
+
+    ; smp_ap_main never returns
+.hang:
+    cli
+    hlt
+    jmp .hang
+
+; flat code and data segments, they are used until the CPU loads its own GDT
+trampoline_gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF
+    dq 0x00CF92000000FFFF
+trampoline_gdt_descriptor:
+    dw trampoline_gdt_descriptor - trampoline_gdt - 1
+    dd TRAMPOLINE(trampoline_gdt)
+
+smp_trampoline_stack:
+    dd 0
+smp_trampoline_cr3:
+    dd 0
+smp_trampoline_entry:
+    dd 0
+smp_trampoline_end:
@@ -0,0 +1,53 @@
+[BITS 32]
+section .asm
+
+global fpu_enable
+global fpu_set_task_switched
+global fpu_clear_task_switched
+global fpu_save
+global fpu_restore
+
+; void fpu_enable();
+; native x87 error reporting and SSE (FXSAVE/FXRSTOR) for the current CPU
+fpu_enable:
+    mov eax, cr0
+    and eax, ~0x04      ; EM off, the x87 instructions are not emulated
+    or eax, 0x22        ; MP (wait honours TS) and NE (native x87 errors)
+    mov cr0, eax
+
+    mov eax, cr4
+    or eax, 0x600       ; OSFXSR and OSXMMEXCPT
+    mov cr4, eax
+
+    clts
+    fninit
+    ; default SSE control, all exceptions masked
+    push dword 0x1F80
+    ldmxcsr [esp]
+    add esp, 4
+    ret
+
+; void fpu_set_task_switched();
+; the next FPU/SSE instruction raises #NM (interrupt 7)
+fpu_set_task_switched:
+    mov eax, cr0
+    or eax, 0x08        ; TS
+    mov cr0, eax
+    ret
+
+; void fpu_clear_task_switched();
+fpu_clear_task_switched:
+    clts
+    ret
+
+; void fpu_save(void* area);
+fpu_save:
+    mov eax, [esp+4]
+    fxsave [eax]
+    ret
+
+; void fpu_restore(void* area);
+fpu_restore:
+    mov eax, [esp+4]
+    fxrstor [eax]
+    ret
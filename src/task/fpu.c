@@ -0,0 +1,100 @@
+#include "fpu.h"
+#include "task.h"
+#include "process.h"
+#include "kernel.h"
+#include "idt/idt.h"
+#include "smp/smp.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+
+/** @brief #NM, an FPU/SSE instruction is run while CR0.TS is set */
+#define FPU_DEVICE_NOT_AVAILABLE_INTERRUPT 7
+
+/** @brief the registers right after fninit, a task starts using the FPU with them */
+static uint8_t fpu_initial_state[FPU_STATE_SIZE] __attribute__((aligned(16)));
+
+/** @brief #NM handler, load the registers of the current task */
+static void fpu_handle_device_not_available(struct interrupt_frame* frame)
+{
+    if ((frame->cs & 0x03) == 0)
+    {
+        panic("FPU used in kernel mode\n");
+    }
+
+    struct cpu* cpu = cpu_current();
+    struct task* task = task_current();
+    fpu_clear_task_switched();
+
+    // The registers of the task are still in this CPU, nobody used the FPU meanwhile
+    if (cpu->fpu_owner == task && task->fpu_cpu == cpu)
+    {
+        cpu->fpu_active = true;
+        return;
+    }
+
+    if (!task->fpu_state)
+    {
+        // The heap blocks are page aligned, the FXSAVE area needs 16 bytes
+        task->fpu_state = kzalloc(FPU_STATE_SIZE);
+        if (!task->fpu_state)
+        {
+            fpu_set_task_switched();
+            process_terminate(task->process);
+
+            /* notice that we never return from here, the task is stopped */
+            task_next();
+        }
+
+        memcpy(task->fpu_state, fpu_initial_state, FPU_STATE_SIZE);
+    }
+
+    fpu_restore(task->fpu_state);
+    cpu->fpu_owner = task;
+    cpu->fpu_active = true;
+    task->fpu_cpu = cpu;
+}
+
+void fpu_init()
+{
+    fpu_enable();
+    fpu_save(fpu_initial_state);
+    fpu_set_task_switched();
+
+    idt_register_interrupt_callback(FPU_DEVICE_NOT_AVAILABLE_INTERRUPT, fpu_handle_device_not_available);
+}
+
+void fpu_init_ap()
+{
+    fpu_enable();
+    fpu_set_task_switched();
+}
+
+void fpu_switch(struct cpu* cpu, struct task* prev)
+{
+    if (cpu->fpu_active)
+    {
+        // The task may run on another CPU next time, its registers must be in memory
+        fpu_save(prev->fpu_state);
+        cpu->fpu_active = false;
+    }
+
+    fpu_set_task_switched();
+}
+
+void fpu_task_free(struct task* task)
+{
+    for (int i = 0; i < smp_cpu_count(); i++)
+    {
+        struct cpu* cpu = cpu_get(i);
+        if (cpu->fpu_owner == task)
+        {
+            cpu->fpu_owner = 0;
+        }
+    }
+
+    if (task->fpu_state)
+    {
+        kfree(task->fpu_state);
+        task->fpu_state = 0;
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef FPU_H
+#define FPU_H
+
+#include <stdbool.h>
+
+/** @file fpu.h
+ * @brief The x87 FPU and SSE registers are switched lazily. A task switch only sets CR0.TS,
+ * the first FPU/SSE instruction of the next task then raises #NM (interrupt 7) and the
+ * registers of the task are loaded there. A task which never touches the FPU pays nothing.
+ *
+ * A task that used the FPU in its time slice has its registers saved when it is switched
+ * out, so it can be stolen by another CPU. Its registers stay loaded in the CPU though, and
+ * they are not loaded again if it is the next one on that CPU to use the FPU.
+*/
+
+/** @brief size of the FXSAVE area, it must be 16 bytes aligned */
+#define FPU_STATE_SIZE 512
+
+struct cpu;
+struct task;
+
+/** @brief enable the FPU and SSE on the BSP, take the clean register state new tasks start
+ * with and register the #NM handler */
+void fpu_init();
+
+/** @brief enable the FPU and SSE on an AP */
+void fpu_init_ap();
+
+/** @brief enable the FPU and SSE on the current CPU (in asm file) */
+void fpu_enable();
+
+/** @brief save the registers of the task leaving the CPU if it used the FPU, and make the
+ * next task trap on its first FPU instruction */
+void fpu_switch(struct cpu* cpu, struct task* prev);
+
+/** @brief forget the task, its FPU state is freed */
+void fpu_task_free(struct task* task);
+
+/** @brief CR0.TS and the FXSAVE/FXRSTOR instructions (in asm file) */
+void fpu_set_task_switched();
+void fpu_clear_task_switched();
+void fpu_save(void* area);
+void fpu_restore(void* area);
+
+#endif
@@ -0,0 +1,23 @@
+#include "mutex.h"
+#include "task.h"
+
+void mutex_init(struct mutex* mutex)
+{
+    mutex->locked = false;
+    mutex->owner = 0;
+    wait_queue_init(&mutex->waiters);
+}
+
+void mutex_lock(struct mutex* mutex)
+{
+    wait_event(&mutex->waiters, !mutex->locked);
+    mutex->locked = true;
+    mutex->owner = task_current();
+}
+
+void mutex_unlock(struct mutex* mutex)
+{
+    mutex->locked = false;
+    mutex->owner = 0;
+    wake_up(&mutex->waiters);
+}
@@ -0,0 +1,37 @@
+#ifndef MUTEX_H
+#define MUTEX_H
+
+#include <stdbool.h>
+
+#include "waitqueue.h"
+
+/** @file mutex.h
+ * @brief A sleeping lock for kernel code that may be preempted at a preemption point
+ * while it works on shared state, i.e. the disk stream of the filesystem. A task waiting
+ * for the mutex sleeps on its wait queue.
+ *
+ * @note interrupt handlers must not take a mutex since they can not sleep
+*/
+
+struct task;
+
+struct mutex
+{
+    bool locked;
+
+    /** @brief the task holding the mutex, zero while the kernel is booting */
+    struct task* owner;
+
+    /** @brief tasks waiting for the mutex to be unlocked */
+    struct wait_queue waiters;
+};
+
+void mutex_init(struct mutex* mutex);
+
+/** @brief take the mutex, the current task sleeps until the mutex is unlocked */
+void mutex_lock(struct mutex* mutex);
+
+/** @brief release the mutex and wake up the tasks waiting for it */
+void mutex_unlock(struct mutex* mutex);
+
+#endif
@@ -0,0 +1,187 @@
+#include "pid.h"
+#include "process.h"
+#include "config.h"
+#include "status.h"
+#include "memory/memory.h"
+#include "memory/heap/kheap.h"
+
+#define PID_BITMAP_WORDS (MAEROS_MAX_PID / 32)
+
+/** @brief one bit per process id, set when the id is in use */
+static uint32_t pid_bitmap[PID_BITMAP_WORDS];
+
+/** @brief the id handed out last, the search for a free one starts after it */
+static int pid_last = 0;
+
+/** @brief number of ids in use, so a full bitmap is not searched */
+static uint32_t pid_used = 0;
+
+/** @brief the hash table, a bucket is the head of a chain linked through process->pid_next */
+static struct process* pid_initial_buckets[MAEROS_PID_HASH_INITIAL_BUCKETS];
+static struct process** pid_buckets = pid_initial_buckets;
+static uint32_t pid_bucket_count = MAEROS_PID_HASH_INITIAL_BUCKETS;
+static uint32_t pid_process_count = 0;
+
+/** @brief all processes in the table, linked through process->list_next */
+static struct process* pid_list = 0;
+
+static bool pid_is_used(int pid)
+{
+    return pid_bitmap[pid / 32] & (1 << (pid % 32));
+}
+
+int pid_alloc()
+{
+    // Id 0 is never handed out
+    if (pid_used >= MAEROS_MAX_PID - 1)
+    {
+        return -EISTKN;
+    }
+
+    int pid = pid_last;
+    while (true)
+    {
+        pid = (pid + 1) % MAEROS_MAX_PID;
+
+        // Skip the full words, the next id to check is the first of the next word
+        if ((pid % 32) == 0 && pid_bitmap[pid / 32] == 0xFFFFFFFF)
+        {
+            pid += 31;
+            continue;
+        }
+
+        if (pid != 0 && !pid_is_used(pid))
+        {
+            break;
+        }
+    }
+
+    pid_bitmap[pid / 32] |= (1 << (pid % 32));
+    pid_used++;
+    pid_last = pid;
+    return pid;
+}
+
+void pid_free(int pid)
+{
+    if (pid <= 0 || pid >= MAEROS_MAX_PID || !pid_is_used(pid))
+    {
+        return;
+    }
+
+    pid_bitmap[pid / 32] &= ~(1 << (pid % 32));
+    pid_used--;
+}
+
+static uint32_t pid_hash(int pid, uint32_t bucket_count)
+{
+    // Ids are handed out in order, the low bits spread them well enough
+    return (uint32_t) pid & (bucket_count - 1);
+}
+
+/** @brief double the buckets and move every process into its new bucket */
+static int pid_grow()
+{
+    uint32_t bucket_count = pid_bucket_count * 2;
+    struct process** buckets = kzalloc(bucket_count * sizeof(struct process*));
+    if (!buckets)
+    {
+        return -ENOMEM;
+    }
+
+    for (struct process* process = pid_list; process; process = process->list_next)
+    {
+        uint32_t bucket = pid_hash(process->id, bucket_count);
+        process->pid_next = buckets[bucket];
+        buckets[bucket] = process;
+    }
+
+    if (pid_buckets != pid_initial_buckets)
+    {
+        kfree(pid_buckets);
+    }
+
+    pid_buckets = buckets;
+    pid_bucket_count = bucket_count;
+    return 0;
+}
+
+int pid_attach(struct process* process)
+{
+    uint32_t bucket = pid_hash(process->id, pid_bucket_count);
+    process->pid_next = pid_buckets[bucket];
+    pid_buckets[bucket] = process;
+
+    process->list_prev = 0;
+    process->list_next = pid_list;
+    if (pid_list)
+    {
+        pid_list->list_prev = process;
+    }
+    pid_list = process;
+    pid_process_count++;
+
+    // The chains just get longer if there is no memory to grow
+    if (pid_process_count > pid_bucket_count * 2)
+    {
+        return pid_grow();
+    }
+
+    return 0;
+}
+
+void pid_detach(struct process* process)
+{
+    struct process** link = &pid_buckets[pid_hash(process->id, pid_bucket_count)];
+    while (*link && *link != process)
+    {
+        link = &(*link)->pid_next;
+    }
+
+    if (!*link)
+    {
+        return;
+    }
+
+    *link = process->pid_next;
+    process->pid_next = 0;
+
+    if (process->list_prev)
+    {
+        process->list_prev->list_next = process->list_next;
+    }
+    else
+    {
+        pid_list = process->list_next;
+    }
+
+    if (process->list_next)
+    {
+        process->list_next->list_prev = process->list_prev;
+    }
+
+    process->list_next = 0;
+    process->list_prev = 0;
+    pid_process_count--;
+}
+
+struct process* pid_lookup(int pid)
+{
+    if (pid <= 0 || pid >= MAEROS_MAX_PID)
+    {
+        return 0;
+    }
+
+    struct process* process = pid_buckets[pid_hash(pid, pid_bucket_count)];
+    while (process && process->id != pid)
+    {
+        process = process->pid_next;
+    }
+
+    return process;
+}
+
+struct process* pid_any()
+{
+    return pid_list;
+}
@@ -0,0 +1,43 @@
+#ifndef PID_H
+#define PID_H
+
+#include <stdint.h>
+
+/** @file pid.h
+ * @brief Process ids and the table mapping them to processes.
+ *
+ * The ids in use are kept in a bitmap. A new id is the first free one after the last id
+ * handed out, so an id is not given again until the whole id space has wrapped around;
+ * a program holding the id of an exited process does not see a new process under it.
+ * The search skips a full word (32 ids) at a time.
+ *
+ * The processes are found by id through a hash table chained through the processes
+ * themselves. The table doubles its buckets when it has more than two processes per
+ * bucket, so the lookup stays O(1) with hundreds of processes. All processes are also
+ * linked into a list, for the callers that want any one of them.
+*/
+
+struct process;
+
+/** @brief reserve a free process id
+ * @retval the id, or -EISTKN when every id is in use
+*/
+int pid_alloc();
+
+/** @brief give 'pid' back, it is handed out again only after the id space wraps around */
+void pid_free(int pid);
+
+/** @brief add 'process' to the table under its id, it fails with -ENOMEM only if the table
+ * has to grow and there is no memory, the process is in the table anyway */
+int pid_attach(struct process* process);
+
+/** @brief remove 'process' from the table, its id is still reserved until pid_free */
+void pid_detach(struct process* process);
+
+/** @brief the process with id 'pid', or null if there is none */
+struct process* pid_lookup(int pid);
+
+/** @brief a process of the table, or null if it is empty */
+struct process* pid_any();
+
+#endif
@@ -9,12 +9,17 @@
 #include "memory/paging/paging.h"
 #include "kernel.h"
 #include "loader/formats/elfloader.h"
+#include "loader/formats/elflink.h"
+#include "mutex.h"
+#include "vdso.h"
+#include "pid.h"
+#include "smp/smp.h"
 
 /** @brief The current process that is running */
 struct process* current_process = 0;
 
-/** @brief created processes list*/
-static struct process* processes[MAEROS_MAX_PROCESSES] = {};
+/** @brief loading a process can be preempted, it keeps the loads one at a time */
+static struct mutex process_load_lock = {};
 
 /** @brief initialize process by clearing 'process' */
 static void process_init(struct process* process)
@@ -28,15 +33,10 @@ struct process* process_current()
     return current_process;
 }
 
-/** @brief return process from processes array */
+/** @brief return the process with id 'process_id' */
 struct process* process_get(int process_id)
 {
-    if (process_id < 0 || process_id >= MAEROS_MAX_PROCESSES)
-    {
-        return NULL;
-    }
-
-    return processes[process_id];
+    return pid_lookup(process_id);
 }
 
 /** @brief switch process  */
@@ -46,22 +46,74 @@ int process_switch(struct process* process)
     return 0;
 }
 
-/** @brief find a free index that is not allocated for that process */
-static int process_find_free_allocation_index(struct process* process)
+/** @brief the entry of the table 'ptr' goes to if there is no collision */
+static uint32_t process_allocation_home(void* ptr, uint32_t capacity)
+{
+    // The pointers are heap blocks, the bits below the block size are always zero
+    return (((uint32_t) ptr / MAEROS_HEAP_BLOCK_SIZE) * 2654435761u) & (capacity - 1);
+}
+
+/** @brief the entry of the table where 'ptr' is, or the free entry where it would go */
+static uint32_t process_allocation_index(struct process_allocation* entries, uint32_t capacity, void* ptr)
 {
-    int res = -ENOMEM;
-    for (int i = 0; i < MAEROS_MAX_PROGRAM_ALLOCATIONS; i++)
+    uint32_t index = process_allocation_home(ptr, capacity);
+    while (entries[index].ptr && entries[index].ptr != ptr)
+    {
+        index = (index + 1) & (capacity - 1);
+    }
+
+    return index;
+}
+
+/** @brief move the allocations into a table twice as big, or create the first table */
+static int process_allocations_grow(struct process* process)
+{
+    struct process_allocations* allocations = &process->allocations;
+    uint32_t capacity = allocations->capacity ? allocations->capacity * 2 : MAEROS_PROCESS_ALLOCATIONS_INITIAL;
+    struct process_allocation* entries = kzalloc(capacity * sizeof(struct process_allocation));
+    if (!entries)
+    {
+        return -ENOMEM;
+    }
+
+    for (uint32_t i = 0; i < allocations->capacity; i++)
     {
-        if (process->allocations[i].ptr == 0)
+        struct process_allocation* allocation = &allocations->entries[i];
+        if (allocation->ptr)
         {
-            res = i;
-            break;
+            entries[process_allocation_index(entries, capacity, allocation->ptr)] = *allocation;
         }
     }
 
-    return res;
+    if (allocations->entries)
+    {
+        kfree(allocations->entries);
+    }
+
+    allocations->entries = entries;
+    allocations->capacity = capacity;
+    return 0;
 }
 
+/** @brief add pointer address to the "allocation" table of a process */
+static int process_allocation_join(struct process* process, void* ptr, size_t size)
+{
+    struct process_allocations* allocations = &process->allocations;
+    if ((allocations->count + 1) * 4 > allocations->capacity * 3)
+    {
+        int res = process_allocations_grow(process);
+        if (res < 0)
+        {
+            return res;
+        }
+    }
+
+    struct process_allocation* allocation = &allocations->entries[process_allocation_index(allocations->entries, allocations->capacity, ptr)];
+    allocation->ptr = ptr;
+    allocation->size = size;
+    allocations->count++;
+    return 0;
+}
 
 void* process_malloc(struct process* process, size_t size)
 {
@@ -71,11 +123,6 @@ void* process_malloc(struct process* process, size_t size)
         goto out_err;
     }
 
-    int index = process_find_free_allocation_index(process);
-    if (index < 0)
-    {
-        goto out_err;
-    }
     /* It maps the memory from the pointer virtual address to the pointer 
     physical address so they share the same virtual address and physical address 
     and it maps it to the pointer plus size, which is the end of the the allocation.
@@ -86,8 +133,12 @@ void* process_malloc(struct process* process, size_t size)
         goto out_err;
     }
 
-    process->allocations[index].ptr = ptr;
-    process->allocations[index].size = size;
+    res = process_allocation_join(process, ptr, size);
+    if (res < 0)
+    {
+        paging_map_to(process->task->page_directory, ptr, ptr, paging_align_address(ptr+size), 0x00);
+        goto out_err;
+    }
     return ptr;
 
 out_err:
@@ -98,54 +149,77 @@ out_err:
     return 0;
 }
 
+/** @brief the function return pointer and its size (for that process) */
+static struct process_allocation* process_get_allocation_by_addr(struct process* process, void* addr)
+{
+    struct process_allocations* allocations = &process->allocations;
+    if (!addr || !allocations->entries)
+    {
+        return 0;
+    }
+
+    struct process_allocation* allocation = &allocations->entries[process_allocation_index(allocations->entries, allocations->capacity, addr)];
+    return allocation->ptr ? allocation : 0;
+}
+
 /** @brief function that will check if we can access that pointer
  * it may belongs to other process
 */
 static bool process_is_process_pointer(struct process* process, void* ptr)
 {
-    for (int i = 0; i < MAEROS_MAX_PROGRAM_ALLOCATIONS; i++)
-    {
-        if (process->allocations[i].ptr == ptr)
-            return true;
-    }
-
-    return false;
+    return process_get_allocation_by_addr(process, ptr) != 0;
 }
 
 
-/** @brief clear pointer address from "allocation" list of a process */
-static void process_allocation_unjoin(struct process* process, void* ptr)
+/** @brief clear pointer address from "allocation" table of a process, the entries after it
+ * which collided with it are moved back so that a lookup still finds them
+*/
+static void process_allocation_unjoin(struct process* process, struct process_allocation* allocation)
 {
-    for (int i = 0; i < MAEROS_MAX_PROGRAM_ALLOCATIONS; i++)
-    {
-        if (process->allocations[i].ptr == ptr)
+    struct process_allocations* allocations = &process->allocations;
+    uint32_t mask = allocations->capacity - 1;
+    uint32_t hole = allocation - allocations->entries;
+    uint32_t index = hole;
+    while (true)
+    {
+        index = (index + 1) & mask;
+        struct process_allocation* next = &allocations->entries[index];
+        if (!next->ptr)
         {
-            process->allocations[i].ptr = 0x00;
-            process->allocations[i].size = 0;
+            break;
         }
-    }
-}
 
-
-/** @brief the function return pointer and its size (for that process) */
-static struct process_allocation* process_get_allocation_by_addr(struct process* process, void* addr)
-{
-    for (int i = 0; i < MAEROS_MAX_PROGRAM_ALLOCATIONS; i++)
-    {
-        if (process->allocations[i].ptr == addr)
-            return &process->allocations[i];
+        // An entry can fill the hole unless its home entry lies after the hole
+        uint32_t home = process_allocation_home(next->ptr, allocations->capacity);
+        if (((index - home) & mask) >= ((index - hole) & mask))
+        {
+            allocations->entries[hole] = *next;
+            hole = index;
+        }
     }
 
-    return 0;
+    allocations->entries[hole].ptr = 0x00;
+    allocations->entries[hole].size = 0;
+    allocations->count--;
 }
 
 int process_terminate_allocations(struct process* process)
 {
-    for (int i = 0; i < MAEROS_MAX_PROGRAM_ALLOCATIONS; i++)
+    // The page directory goes away with the process, the memory is just given back
+    struct process_allocations* allocations = &process->allocations;
+    for (uint32_t i = 0; i < allocations->capacity; i++)
     {
-        process_free(process, process->allocations[i].ptr);
+        if (allocations->entries[i].ptr)
+        {
+            kfree(allocations->entries[i].ptr);
+        }
     }
 
+    if (allocations->entries)
+    {
+        kfree(allocations->entries);
+    }
+    memset(allocations, 0, sizeof(struct process_allocations));
     return 0;
 }
 
@@ -184,23 +258,21 @@ int process_free_program_data(struct process* process)
 /** @brief when a process is terminated, switch to other process */
 void process_switch_to_any()
 {
-    for (int i = 0; i < MAEROS_MAX_PROCESSES; i++)
+    struct process* process = pid_any();
+    if (!process)
     {
-        if (processes[i])
-        {
-            process_switch(processes[i]);
-            return;
-        }
+        panic("No processes to switch too\n");
     }
 
-
-    panic("No processes to switch too\n");
+    process_switch(process);
 }
 
-/** @brief remove process from processes array */
+/** @brief remove process from the process table, its id is free but it is not handed out again
+ * until the ids wrap around */
 static void process_unlink(struct process* process)
 {
-    processes[process->id] = 0x00;
+    pid_detach(process);
+    pid_free(process->id);
 
     if (current_process == process)
     {
@@ -208,35 +280,249 @@ static void process_unlink(struct process* process)
     }
 }
 
-/** @brief terminate/end of a process */
-int process_terminate(struct process* process)
+/** @brief virtual address of the top of the user stack of thread 'thread_id', the stacks
+ * lie below each other under the program */
+static void* process_thread_stack_top(int thread_id)
 {
-    int res = 0;
-    /* remove all malloc for the process*/
-    res = process_terminate_allocations(process);
-    if (res < 0)
+    return (void*)(MAEROS_PROGRAM_VIRTUAL_STACK_ADDRESS_START - thread_id * MAEROS_USER_PROGRAM_STACK_SIZE);
+}
+
+/** @brief unmap the user stack of thread 'thread_id' from the process and free it */
+static void process_thread_free_stack(struct process* process, int thread_id, void* stack)
+{
+    void* virtual_end = process_thread_stack_top(thread_id) - MAEROS_USER_PROGRAM_STACK_SIZE;
+    paging_map_to(process->task->page_directory, virtual_end, virtual_end, process_thread_stack_top(thread_id), 0x00);
+    kfree(stack);
+}
+
+/** @brief give the slot of an exited or stopped thread back, the main thread is freed with
+ * the process since the page directory belongs to its task
+*/
+static void process_thread_release(struct process* process, int thread_id)
+{
+    struct process_thread* thread = &process->threads[thread_id];
+    if (thread_id == 0 || !thread->task)
     {
-        goto out;
+        return;
     }
 
-    /* */
-    res = process_free_program_data(process);
-    if (res < 0)
+    task_free(thread->task);
+    process_thread_free_stack(process, thread_id, thread->stack);
+    memset(thread, 0, sizeof(struct process_thread));
+}
+
+/** @brief work item giving the memory of a terminated process back, it runs in the kernel worker */
+static void process_reclaim(struct work* work)
+{
+    struct process* process = work->data;
+
+    // Free the threads first, they use the page directory of the main task
+    for (int i = 1; i < MAEROS_MAX_THREADS; i++)
     {
-        goto out;
+        process_thread_release(process, i);
     }
 
+    /* remove all malloc for the process*/
+    process_terminate_allocations(process);
+    process_free_program_data(process);
+
     // Free the process stack memory.
     kfree(process->stack);
+    if (process->ring)
+    {
+        kfree(process->ring);
+    }
+    vdso_free(process);
     // Free the task
     task_free(process->task);
+    kfree(process);
+}
+
+/** @brief whether a task of the process is the running task of a CPU, its kernel stack and
+ * page directory are in use then */
+static bool process_on_cpu(struct process* process)
+{
+    for (int i = 0; i < smp_cpu_count(); i++)
+    {
+        struct task* current = cpu_get(i)->run_queue.current;
+        if (current && current->process == process)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/** @brief queue the reclaim of a terminated process unless a CPU still runs one of its tasks,
+ * the last CPU switching away from them queues it then (see process_task_switched_out) */
+static void process_reclaim_when_off_cpu(struct process* process)
+{
+    if (!process_on_cpu(process))
+    {
+        workqueue_schedule(&process->reclaim_work);
+    }
+}
+
+/** @brief terminate/end of a process
+ *
+ * @note the process stops running right away, its memory is freed later by the kernel
+ * work queue so that a syscall or an exception does not spend time on it. A thread running
+ * on another CPU is switched away from there first, the memory is freed after that.
+*/
+int process_terminate(struct process* process)
+{
+    // The tasks are never scheduled again, a CPU running one of them is told to leave it
+    for (int i = 0; i < MAEROS_MAX_THREADS; i++)
+    {
+        if (process->threads[i].task)
+        {
+            task_stop(process->threads[i].task);
+        }
+    }
     // Unlink the process from the process array.
     process_unlink(process);
 
+    process->terminated = true;
+    work_init(&process->reclaim_work, process_reclaim, process);
+    process_reclaim_when_off_cpu(process);
+    return 0;
+}
+
+void process_task_switched_out(struct task* task)
+{
+    if (task->process && task->process->terminated)
+    {
+        process_reclaim_when_off_cpu(task->process);
+    }
+}
+
+/** @brief find the slot of the thread running 'task' */
+static int process_thread_id(struct process* process, struct task* task)
+{
+    for (int i = 0; i < MAEROS_MAX_THREADS; i++)
+    {
+        if (process->threads[i].task == task)
+        {
+            return i;
+        }
+    }
+
+    return -EINVARG;
+}
+
+/** @brief whether a thread of the process has not exited yet */
+static bool process_has_running_threads(struct process* process)
+{
+    for (int i = 0; i < MAEROS_MAX_THREADS; i++)
+    {
+        if (process->threads[i].task && !process->threads[i].exited)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+int process_thread_create(struct process* process, uint32_t entry, uint32_t function, uint32_t arg)
+{
+    int res = 0;
+    void* stack = 0;
+    int thread_id = process_thread_id(process, 0);
+    if (thread_id < 0)
+    {
+        res = -EISTKN;
+        goto out;
+    }
+
+    stack = kzalloc(MAEROS_USER_PROGRAM_STACK_SIZE);
+    if (!stack)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    void* stack_top = process_thread_stack_top(thread_id);
+    res = paging_map_to(process->task->page_directory, stack_top - MAEROS_USER_PROGRAM_STACK_SIZE, stack, paging_align_address(stack+MAEROS_USER_PROGRAM_STACK_SIZE), PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL | PAGING_IS_WRITEABLE);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    /* the stdlib start routine at 'entry' pops the function and calls it, so the argument
+    is where the function expects it */
+    uint32_t* sp = (uint32_t*)(stack + MAEROS_USER_PROGRAM_STACK_SIZE);
+    *--sp = arg;
+    *--sp = function;
+
+    struct task* task = task_new_thread(process, entry, (uint32_t) stack_top - 2 * sizeof(uint32_t));
+    if (ISERR(task))
+    {
+        res = ERROR_I(task);
+        goto out;
+    }
+
+    process->threads[thread_id].task = task;
+    process->threads[thread_id].stack = stack;
+    res = thread_id;
+
 out:
+    if (ISERR(res) && stack)
+    {
+        process_thread_free_stack(process, thread_id, stack);
+    }
     return res;
 }
 
+void process_thread_exit(struct task* task, int exit_code)
+{
+    struct process* process = task->process;
+    int thread_id = process_thread_id(process, task);
+    if (thread_id < 0)
+    {
+        panic("process_thread_exit(): The task is not a thread of its process\n");
+    }
+
+    task_stop(task);
+    process->threads[thread_id].exited = true;
+    process->threads[thread_id].exit_code = exit_code;
+
+    if (!process_has_running_threads(process))
+    {
+        process_terminate(process);
+        return;
+    }
+
+    wake_up(&process->joiners);
+}
+
+int process_thread_join(struct process* process, int thread_id, int* exit_code)
+{
+    if (thread_id < 0 || thread_id >= MAEROS_MAX_THREADS)
+    {
+        return -EINVARG;
+    }
+
+    struct process_thread* thread = &process->threads[thread_id];
+    struct task* task = thread->task;
+    if (!task || task == task_current())
+    {
+        return -EINVARG;
+    }
+
+    // Another thread may join it first and give the slot back meanwhile
+    wait_event(&process->joiners, thread->exited || thread->task != task);
+    if (thread->task != task)
+    {
+        return -EINVARG;
+    }
+
+    *exit_code = thread->exit_code;
+    process_thread_release(process, thread_id);
+    return 0;
+}
+
 /** @brief get process arguments and fill 'argc' and 'argv' */
 void process_get_arguments(struct process* process, int* argc, char*** argv)
 {
@@ -325,7 +611,7 @@ void process_free(struct process* process, void* ptr)
     }
 
     // Unjoin the allocation
-    process_allocation_unjoin(process, ptr);
+    process_allocation_unjoin(process, allocation);
 
     // We can now free the memory.
     kfree(ptr);
@@ -409,6 +695,17 @@ static int process_load_data(const char* filename, struct process* process)
     {
         res = process_load_binary(filename, process);
     }
+    else if (res == 0)
+    {
+        /* load the shared libraries the program needs and relocate them with the program,
+        it is an ELF file even if it cannot be linked so it is not run as a binary */
+        res = elf_link(process->elf_file);
+        if (ISERR(res))
+        {
+            elf_close(process->elf_file);
+            process->elf_file = 0;
+        }
+    }
 
     //res = process_load_binary(filename, process);
 
@@ -431,27 +728,22 @@ int process_map_binary(struct process* process)
     // return res;
 }
 
-/** @brief map process to virtual addresses if file type is .elf */
-static int process_map_elf(struct process* process)
+/** @brief map the segments of the program or shared library 'file' where it is loaded */
+static int process_map_elf_file(struct process* process, struct elf_file* file)
 {
     int res = 0;
-
-    struct elf_file* elf_file = process->elf_file;
-    /* get elf header */
-    struct elf_header* header = elf_header(elf_file);
-    /* get program headers */
-    struct elf32_phdr* phdrs = elf_pheader(header);
-
-    for (int i = 0; i < header->e_phnum; i++)
+    for (int i = 0; i < file->total_segments; i++)
     {
-        struct elf32_phdr* phdr = &phdrs[i];
-        void* phdr_phys_address = elf_phdr_phys_address(elf_file, phdr);
+        /* a read-only segment is shared by every instance of the program, a writable one
+        is the copy of the process */
+        struct elf_segment* segment = &file->segments[i];
         int flags = PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL;
-        if (phdr->p_flags & PF_W /* if program header is writeable*/)
+        if (segment->phdr->p_flags & PF_W /* if program header is writeable*/)
         {
-            flags |= PAGING_IS_WRITEABLE; /* we also make its physical address is writeable*/
+            flags |= PAGING_IS_WRITEABLE;
         }
-        res = paging_map_to(process->task->page_directory, paging_align_to_lower_page((void*)phdr->p_vaddr), paging_align_to_lower_page(phdr_phys_address), paging_align_address(phdr_phys_address+phdr->p_memsz), flags);
+
+        res = paging_map_to(process->task->page_directory, segment->virtual_address + file->load_bias, segment->memory, segment->memory + segment->size, flags);
         if (ISERR(res))
         {
             break;
@@ -461,6 +753,19 @@ static int process_map_elf(struct process* process)
     return res;
 }
 
+/** @brief map process to virtual addresses if file type is .elf */
+static int process_map_elf(struct process* process)
+{
+    struct elf_file* elf_file = process->elf_file;
+    int res = process_map_elf_file(process, elf_file);
+    for (int i = 0; i < elf_file->total_libraries && !ISERR(res); i++)
+    {
+        res = process_map_elf_file(process, elf_file->libraries[i]);
+    }
+
+    return res;
+}
+
 /** @brief take the process we've loaded and it will map it to the virtual addresses of the 
  * page tables for the process.
  */
@@ -491,35 +796,32 @@ int process_map_memory(struct process* process)
 
      // Finally map the stack
      paging_map_to(process->task->page_directory, (void*)MAEROS_PROGRAM_VIRTUAL_STACK_ADDRESS_END, process->stack, paging_align_address(process->stack+MAEROS_USER_PROGRAM_STACK_SIZE), PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL | PAGING_IS_WRITEABLE);
+
+     // and the data page right above it
+     res = vdso_map(process);
  out:
      return res;
 }
 
-/** @brief pass through process array and find empty slot */
-int process_get_free_slot()
-{
-    for (int i = 0; i < MAEROS_MAX_PROCESSES; i++)
-    {
-        if (processes[i] == 0)
-            return i;
-    }
-
-    return -EISTKN;
-}
-
-/** @brief find a empty slot and load process to the that index in process array */
+/** @brief reserve a process id and load the process under it */
 int process_load(const char* filename, struct process** process)
 {
     int res = 0;
-    int process_slot = process_get_free_slot();
-    if (process_slot < 0)
+    mutex_lock(&process_load_lock);
+    int pid = pid_alloc();
+    if (pid < 0)
     {
-        res = -EISTKN;
+        res = pid;
         goto out;
     }
 
-    res = process_load_for_slot(filename, process, process_slot);
+    res = process_load_for_pid(filename, process, pid);
+    if (res < 0)
+    {
+        pid_free(pid);
+    }
 out:
+    mutex_unlock(&process_load_lock);
     return res;
 }
 
@@ -534,17 +836,15 @@ int process_load_switch(const char* filename, struct process** process)
     return res;
 }
 
-/** @brief slot means index of process array named 'processes' 
- * process load for slot will load the given 'filename' as a process into memory.
-*/
-int process_load_for_slot(const char* filename, struct process** process, int process_slot)
+/** @brief load the given 'filename' as a process into memory under the reserved id 'pid' */
+int process_load_for_pid(const char* filename, struct process** process, int pid)
 {
     int res = 0;
     struct task* task = 0;
-    struct process* _process;
+    struct process* _process = 0;
     void* program_stack_ptr = 0;
 
-    if (process_get(process_slot) != 0)
+    if (process_get(pid) != 0)
     {
         res = -EISTKN;
         goto out;
@@ -573,17 +873,19 @@ int process_load_for_slot(const char* filename, struct process** process, int pr
 
     strncpy(_process->filename, filename, sizeof(_process->filename));
     _process->stack = program_stack_ptr;
-    _process->id = process_slot;
+    _process->id = pid;
 
     // Create a task
     task = task_new(_process);
-    if (ERROR_I(task) == 0)
+    if (ISERR(task))
     {
         res = ERROR_I(task);
         goto out;
     }
 
     _process->task = task;
+    _process->threads[0].task = task;
+    _process->threads[0].stack = program_stack_ptr;
 
     res = process_map_memory(_process);
     if (res < 0)
@@ -593,18 +895,30 @@ int process_load_for_slot(const char* filename, struct process** process, int pr
 
     *process = _process;
 
-    // Add the process to the array
-    processes[process_slot] = _process;
+    // Add the process to the table, it is found by its id from now on
+    pid_attach(_process);
 
 out:
-    if (ISERR(res))
+    if (ISERR(res) && _process)
     {
-        if (_process && _process->task)
+        if (_process->task)
         {
             task_free(_process->task);
         }
 
-       // Free the process data
+        // The pointer is set once the program is loaded, closing it releases the cached image
+        if (_process->ptr)
+        {
+            process_free_program_data(_process);
+        }
+
+        if (program_stack_ptr)
+        {
+            kfree(program_stack_ptr);
+        }
+
+        vdso_free(_process);
+        kfree(_process);
     }
     return res;
 }
\ No newline at end of file
@@ -4,7 +4,10 @@
 #include <stdbool.h>
 
 #include "task.h"
+#include "waitqueue.h"
 #include "config.h"
+#include "isr80h/isr80h.h"
+#include "isr80h/stats.h"
 
 /** @brief Process is accepted as elf file format */
 #define PROCESS_FILETYPE_ELF 0
@@ -13,6 +16,9 @@
 
 typedef unsigned char PROCESS_FILETYPE;
 
+struct isr80h_ring;
+struct vdso_data;
+
 /** @brief keeps pointer and how much memory is allocated for that pointer */
 struct process_allocation
 {
@@ -20,6 +26,18 @@ struct process_allocation
     size_t size;
 };
 
+/** @brief the malloc allocations of a process, a hash table keyed by the pointer. A collision
+ * takes the next free entry (linear probing), an entry with a null pointer is free.
+*/
+struct process_allocations
+{
+    /** @brief null until the first malloc of the process */
+    struct process_allocation* entries;
+    /** @brief number of entries, a power of two */
+    uint32_t capacity;
+    uint32_t count;
+};
+
 struct command_argument
 {
     char argument[512];
@@ -33,12 +51,33 @@ struct process_arguments
     char** argv;
 };
 
+/** @brief A thread of a process, every thread has its own task (registers and kernel stack)
+ * and user stack. Slot 0 is the main thread, its task and stack are the ones of the process.
+*/
+struct process_thread
+{
+    struct task* task;
+
+    /** @brief The physical pointer to the user stack of the thread */
+    void* stack;
+
+    /** @brief The thread called thread_exit, it stays in the slot until it is joined */
+    bool exited;
+    int exit_code;
+};
+
 /** @brief The structure to define a what process is (can it be called PCB Process Control Block?)*/
 struct process
 {
     /** @brief The process id */
     uint16_t id;
 
+    /** @brief The next process in the same bucket of the process id table (see pid.h) */
+    struct process* pid_next;
+    /** @brief The list of all processes */
+    struct process* list_next;
+    struct process* list_prev;
+
     /** @brief file name? */
     char filename[MAEROS_MAX_PATH];
 
@@ -47,7 +86,7 @@ struct process
 
     /** @brief The memory (malloc) allocations that have been made of the process 
     When process is killed, free the memory previously allocated */
-    struct process_allocation allocations[MAEROS_MAX_PROGRAM_ALLOCATIONS];
+    struct process_allocations allocations;
 
     /** @brief Process file type can be .elf or .bin */
     PROCESS_FILETYPE filetype;
@@ -75,16 +114,44 @@ struct process
         char buffer[MAEROS_KEYBOARD_BUFFER_SIZE];
         int tail;
         int head;
+        /** @brief tasks blocked until a key is pushed to the buffer */
+        struct wait_queue readers;
     } keyboard;
 
     // The arguments of the process.
     struct process_arguments arguments;
+
+    /** @brief The threads of the process indexed by thread id, all of them share the page
+     * directory and the allocations of the process */
+    struct process_thread threads[MAEROS_MAX_THREADS];
+
+    /** @brief tasks blocked in thread_join until a thread of the process exits */
+    struct wait_queue joiners;
+
+    /** @brief The batched syscall rings shared with the program, zero until ring_setup (see ring.h) */
+    struct isr80h_ring* ring;
+    uint32_t ring_flags;
+
+    /** @brief The read-only data page the program reads without a syscall (see vdso.h) */
+    struct vdso_data* vdso;
+
+#if MAEROS_SYSCALL_STATS
+    /** @brief call count and latency of the syscalls of the process */
+    struct isr80h_command_stats syscall_stats[SYSTEM_COMMANDS_TOTAL];
+#endif
+
+    /** @brief The process is terminated, its memory is freed once none of its tasks runs on
+     * a CPU any more */
+    bool terminated;
+
+    /** @brief Frees the process memory after it is terminated */
+    struct work reclaim_work;
 };
 
 int process_switch(struct process* process);
 int process_load_switch(const char* filename, struct process** process);
 int process_load(const char* filename, struct process** process);
-int process_load_for_slot(const char* filename, struct process** process, int process_slot);
+int process_load_for_pid(const char* filename, struct process** process, int pid);
 struct process* process_current();
 struct process* process_get(int process_id);
 
@@ -96,4 +163,25 @@ void process_get_arguments(struct process* process, int* argc, char*** argv);
 int process_inject_arguments(struct process* process, struct command_argument* root_argument);
 int process_terminate(struct process* process);
 
+/** @brief a CPU switched away from 'task', it is called by task_switch. The memory of a
+ * terminated process is given back once the last of its tasks left its CPU.
+*/
+void process_task_switched_out(struct task* task);
+
+/** @brief start a new thread of the process in user land at 'entry', 'function' and 'arg' are
+ * put onto its stack for the stdlib thread start routine
+ * @retval the thread id, or a negative error code
+*/
+int process_thread_create(struct process* process, uint32_t entry, uint32_t function, uint32_t arg);
+
+/** @brief stop the thread running 'task', the process is terminated when it was the last one.
+ * The caller switches to the next task afterwards.
+*/
+void process_thread_exit(struct task* task, int exit_code);
+
+/** @brief wait until thread 'thread_id' of the process exits and give its slot back
+ * @retval 0 and the exit code of the thread in 'exit_code', or a negative error code
+*/
+int process_thread_join(struct process* process, int thread_id, int* exit_code);
+
 #endif
\ No newline at end of file
@@ -4,6 +4,7 @@ section .asm
 global restore_general_purpose_registers
 global task_return
 global user_registers
+global task_context_switch
 
 ; void task_return(struct registers* regs);
 task_return:
@@ -16,6 +17,7 @@ task_return:
 
     ; Let's access the structure passed to us
     mov ebx, [ebp+4]
+
     ; push the data/stack selector
     push dword [ebx+44]
     ; Push the stack pointer
@@ -38,6 +40,8 @@ task_return:
     mov ds, ax
     mov es, ax
     mov fs, ax
+    ; gs is the thread local storage segment
+    mov ax, 0x33
     mov gs, ax
 
     push dword [ebp+4]
@@ -46,7 +50,29 @@ task_return:
 
     ; Let's leave kernel land and execute in user land!
     iretd
-    
+
+; void task_context_switch(uint32_t* prev_esp, uint32_t next_esp);
+; save the callee-saved registers on the kernel stack of the previous task and
+; continue on the kernel stack of the next task. The caller saved registers
+; are already saved by the C caller, so nothing else needs to be kept.
+task_context_switch:
+    mov eax, [esp+4]
+    mov edx, [esp+8]
+
+    push ebp
+    push ebx
+    push esi
+    push edi
+
+    mov [eax], esp
+    mov esp, edx
+
+    pop edi
+    pop esi
+    pop ebx
+    pop ebp
+    ret
+
 ; void restore_general_purpose_registers(struct registers* regs);
 restore_general_purpose_registers:
     push ebp
@@ -68,5 +94,7 @@ user_registers:
     mov ds, ax
     mov es, ax
     mov fs, ax
+    ; gs is the thread local storage segment, its base is the thread area of the task
+    mov ax, 0x33
     mov gs, ax
     ret
\ No newline at end of file
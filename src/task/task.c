@@ -8,19 +8,31 @@
 #include "memory/paging/paging.h"
 #include "loader/formats/elfloader.h"
 #include "idt/idt.h"
+#include "waitqueue.h"
+#include "timer/clock.h"
+#include "timer/div64.h"
+#include "workqueue.h"
+#include "smp/smp.h"
+#include "fpu.h"
+#include "vdso.h"
 
-/** @brief The current task that is running*/
-struct task *current_task = 0;
-
-// Task linked list
-struct task *task_tail = 0;
-struct task *task_head = 0;
+/** @brief set once the first task is run, until then kernel_main runs on the boot stack */
+static bool task_scheduler_running = false;
 
 int task_init(struct task *task, struct process *process);
+static void task_list_add(struct task *task);
+static void task_enqueue(struct task *task);
+static int task_init_kernel_stack(struct task *task);
+
+/** @brief the run queue of the CPU running this code */
+static struct run_queue* task_run_queue()
+{
+    return &cpu_current()->run_queue;
+}
 
 struct task *task_current()
 {
-    return current_task;
+    return task_run_queue()->current;
 }
 
 struct task *task_new(struct process *process)
@@ -39,60 +51,286 @@ struct task *task_new(struct process *process)
         goto out;
     }
 
-    if (task_head == 0)
+    res = task_init_kernel_stack(task);
+    if (res != MAEROS_ALL_OK)
     {
-        task_head = task;
-        task_tail = task;
-        current_task = task;
         goto out;
     }
 
-    task_tail->next = task;
-    task->prev = task_tail;
-    task_tail = task;
+    task->cpu = cpu_current();
+    task_enqueue(task);
 
 out:
     if (ISERR(res))
     {
-        task_free(task);
+        if (task)
+        {
+            // The task is not in a run queue yet
+            task->state = TASK_STATE_DEAD;
+            task_free(task);
+        }
         return ERROR(res);
     }
 
     return task;
 }
 
-/** @brief return next task in the linked list */
+struct task* task_new_thread(struct process* process, uint32_t ip, uint32_t esp)
+{
+    int res = 0;
+    struct task* task = kzalloc(sizeof(struct task));
+    if (!task)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    // The thread runs in the address space of the main task
+    task->is_thread = true;
+    task->page_directory = process->task->page_directory;
+    task->registers.ip = ip;
+    task->registers.esp = esp;
+    task->registers.ss = USER_DATA_SEGMENT;
+    task->registers.cs = USER_CODE_SEGMENT;
+    task->process = process;
+    task->state = TASK_STATE_RUNNABLE;
+
+    res = task_init_kernel_stack(task);
+    if (res != MAEROS_ALL_OK)
+    {
+        goto out;
+    }
+
+    task->cpu = cpu_current();
+    task_enqueue(task);
+
+out:
+    if (ISERR(res))
+    {
+        if (task)
+        {
+            // The task is not in a run queue yet
+            task->state = TASK_STATE_DEAD;
+            task_free(task);
+        }
+        return ERROR(res);
+    }
+
+    return task;
+}
+
+/** @brief return next task in the linked list (run queue)
+ * @note the running task is always at the head of the run queue, so the next task is
+ * the one after it. It returns zero when there is no other runnable task
+*/
 struct task *task_get_next()
 {
-    if (!current_task->next)
+    struct run_queue* queue = task_run_queue();
+    if (!queue->current || queue->current != queue->head)
     {
-        return task_head;
+        return queue->head;
     }
 
-    return current_task->next;
+    return queue->current->next;
 }
 
-/** @brief remove task from linked list */
+/** @brief add task to the end of the run queue of its CPU */
+static void task_list_add(struct task *task)
+{
+    struct run_queue* queue = &task->cpu->run_queue;
+    task->next = 0;
+    task->prev = queue->tail;
+
+    if (queue->tail)
+    {
+        queue->tail->next = task;
+    }
+    else
+    {
+        queue->head = task;
+    }
+
+    queue->tail = task;
+    queue->count++;
+}
+
+/** @brief remove task from the run queue of its CPU */
 static void task_list_remove(struct task *task)
 {
+    struct run_queue* queue = &task->cpu->run_queue;
     if (task->prev)
     {
         task->prev->next = task->next;
     }
 
-    if (task == task_head)
+    if (task->next)
+    {
+        task->next->prev = task->prev;
+    }
+
+    if (task == queue->head)
+    {
+        queue->head = task->next;
+    }
+
+    if (task == queue->tail)
+    {
+        queue->tail = task->prev;
+    }
+
+    task->next = 0;
+    task->prev = 0;
+    queue->count--;
+}
+
+/** @brief whether the CPU runs its idle task and nothing waits in its run queue */
+static bool task_cpu_idle(struct cpu* cpu)
+{
+    return cpu->started && task_is_idle(cpu->run_queue.current) && !cpu->run_queue.head;
+}
+
+/** @brief put a runnable task into a run queue. The task stays on its CPU unless that CPU is
+ * busy and another one is idle, the CPU is told about the task if it is not this one
+*/
+static void task_enqueue(struct task *task)
+{
+    if (!task_cpu_idle(task->cpu))
+    {
+        for (int i = 0; i < smp_cpu_count(); i++)
+        {
+            struct cpu* cpu = cpu_get(i);
+            if (task_cpu_idle(cpu))
+            {
+                task->cpu = cpu;
+                break;
+            }
+        }
+    }
+
+    task_list_add(task);
+
+    /* an idle CPU picks the task, a busy one programs the end of the time slice of its
+    current task since it has something else to run now */
+    smp_send_reschedule(task->cpu);
+}
+
+/** @brief move the last task waiting in the longest run queue of the other CPUs to this CPU
+ * @retval true if a task is stolen
+*/
+static bool task_steal(struct cpu* cpu)
+{
+    struct task* task = 0;
+    int most_waiting = 0;
+    for (int i = 0; i < smp_cpu_count(); i++)
+    {
+        struct cpu* other = cpu_get(i);
+        if (other == cpu || !other->started)
+        {
+            continue;
+        }
+
+        // The running task of the other CPU is at the head, it can not be taken
+        struct run_queue* queue = &other->run_queue;
+        int waiting = queue->count;
+        if (queue->current && queue->current == queue->head)
+        {
+            waiting--;
+        }
+
+        if (waiting > most_waiting)
+        {
+            most_waiting = waiting;
+            task = queue->tail;
+        }
+    }
+
+    if (!task)
+    {
+        return false;
+    }
+
+    task_list_remove(task);
+    task->cpu = cpu;
+    task_list_add(task);
+    return true;
+}
+
+void task_block(struct task *task)
+{
+    if (task->state == TASK_STATE_BLOCKED)
+    {
+        return;
+    }
+
+    task->state = TASK_STATE_BLOCKED;
+    task_list_remove(task);
+}
+
+void task_unblock(struct task *task)
+{
+    if (task->state == TASK_STATE_RUNNABLE)
+    {
+        return;
+    }
+
+    task->state = TASK_STATE_RUNNABLE;
+    task_enqueue(task);
+}
+
+/** @brief sleep timer callback, the task is put back into the run queue */
+static void task_sleep_timeout(struct timer* timer)
+{
+    task_unblock(timer->data);
+}
+
+void task_sleep(uint32_t ms)
+{
+    struct task* task = task_current();
+    if (!task)
     {
-        task_head = task->next;
+        panic("task_sleep(): No current task to put to sleep\n");
     }
 
-    if (task == task_tail)
+    /* the task is parked on the timer wheel only, not in the run queue */
+    timer_setup(&task->sleep_timer, task_sleep_timeout, task);
+    timer_add(&task->sleep_timer, timer_ticks() + timer_ms_to_ticks(ms));
+    task_block(task);
+
+    // The BSP programs the timer interrupt of the timer wheel
+    smp_send_reschedule(cpu_get(0));
+
+    // We are back here once the timer wakes us up
+    task_next();
+}
+
+void task_stop(struct task *task)
+{
+    if (task->state == TASK_STATE_BLOCKED)
     {
-        task_tail = task->prev;
+        wait_queue_remove(task);
+        timer_cancel(&task->sleep_timer);
     }
+    else if (task->state == TASK_STATE_RUNNABLE)
+    {
+        task_list_remove(task);
+    }
+
+    task->state = TASK_STATE_DEAD;
 
-    if (task == current_task)
+    // Another CPU may be running it right now, it leaves the task on its next interrupt
+    if (task->cpu && task->cpu->run_queue.current == task)
     {
-        current_task = task_get_next();
+        smp_send_reschedule(task->cpu);
+    }
+}
+
+void task_leave_if_dead()
+{
+    struct task* task = task_current();
+    if (task && task->state == TASK_STATE_DEAD)
+    {
+        /* notice that we never return from here */
+        task_next();
     }
 }
 
@@ -101,32 +339,412 @@ static void task_list_remove(struct task *task)
 */
 int task_free(struct task *task)
 {
-    paging_free_4gb(task->page_directory);
-    task_list_remove(task);
+    task_stop(task);
+
+    // Kernel threads share the kernel page directory, threads the one of their process
+    if (!task_is_kernel(task) && !task->is_thread)
+    {
+        paging_free_4gb(task->page_directory);
+    }
+
+    if (task->kernel_stack)
+    {
+        kfree(task->kernel_stack);
+    }
+
+    fpu_task_free(task);
 
     // Finally free the task data
     kfree(task);
     return 0;
 }
 
+/** @brief whether a task other than the current one waits in the run queue */
+static bool task_others_runnable(struct run_queue* queue)
+{
+    return queue->head && (queue->head != queue->current || queue->head->next);
+}
+
 /** @brief swith to next task */
 void task_next()
 {
-    struct task* next_task = task_get_next();
+    struct cpu* cpu = cpu_current();
+    struct run_queue* queue = &cpu->run_queue;
+
+    /* round robin, the current task goes to the end of the run queue */
+    struct task* current = queue->current;
+    if (current && current == queue->head && current->next)
+    {
+        task_list_remove(current);
+        task_list_add(current);
+    }
+
+    if (!queue->head)
+    {
+        task_steal(cpu);
+    }
+
+    struct task* next_task = queue->head;
     if (!next_task)
     {
-        panic("No more tasks!\n");
+        /* nothing is runnable, halt the CPU until an interrupt wakes a task up */
+        next_task = queue->idle;
     }
 
     task_switch(next_task);
-    task_return(&next_task->registers);
 }
 
-/** @brief changing current/running task, by changing page directory*/
+void task_yield_to(struct task *task)
+{
+    struct run_queue* queue = task_run_queue();
+    if (task == task->cpu->run_queue.current || task->state != TASK_STATE_RUNNABLE)
+    {
+        return;
+    }
+
+    /* move the task right behind the current task (the head of the run queue),
+    task_next moves the current task to the end and picks it */
+    task_list_remove(task);
+    task->cpu = cpu_current();
+    if (queue->current == queue->head && queue->head)
+    {
+        task->prev = queue->head;
+        task->next = queue->head->next;
+        if (queue->head->next)
+        {
+            queue->head->next->prev = task;
+        }
+        else
+        {
+            queue->tail = task;
+        }
+        queue->head->next = task;
+    }
+    else
+    {
+        task->prev = 0;
+        task->next = queue->head;
+        if (queue->head)
+        {
+            queue->head->prev = task;
+        }
+        else
+        {
+            queue->tail = task;
+        }
+        queue->head = task;
+    }
+    queue->count++;
+
+    task_next();
+}
+
+void task_preempt_point()
+{
+    if (!task_scheduler_running)
+    {
+        return;
+    }
+
+    /* let the pending interrupts in, i.e. a key press waking up a task or the
+    timer interrupt ending the time slice. The other CPUs can enter the kernel meanwhile */
+    int depth = kernel_lock_release_all();
+    enable_interrupts();
+    disable_interrupts();
+    kernel_lock_reacquire(depth);
+
+    // Another CPU may have terminated the process meanwhile
+    task_leave_if_dead();
+
+    if (task_quantum_expired() && task_others_runnable(task_run_queue()))
+    {
+        task_next();
+    }
+}
+
+/** @brief body of the idle task, interrupts are only enabled while the CPU is halted.
+ * The CPU gives the big kernel lock up while it is halted, and it looks for a task to steal
+ * every time it wakes up.
+*/
+static void task_idle(void* data)
+{
+    disable_interrupts();
+    while(1)
+    {
+        struct cpu* cpu = cpu_current();
+        if (cpu->run_queue.head || task_steal(cpu))
+        {
+            task_next();
+            continue;
+        }
+
+        kernel_unlock();
+        halt_until_interrupt();
+        kernel_lock();
+    }
+}
+
+/** @brief the first code every task runs, task_context_switch returns here for a new task */
+static void task_entry()
+{
+    struct task* task = task_current();
+
+    // The big kernel lock is passed on by the task switching to us
+    cpu_current()->kernel_lock_depth = 1;
+    task_program_timer();
+
+    if (task_is_kernel(task))
+    {
+        enable_interrupts();
+        task->kernel_function(task->kernel_data);
+        task_exit_kernel();
+    }
+
+    // Drop into user land for the first time
+    task_page();
+    kernel_unlock();
+    task_return(&task->registers);
+}
+
+/** @brief allocate the kernel stack and build the frame task_context_switch pops
+ * when the task is switched to for the first time
+*/
+static int task_init_kernel_stack(struct task *task)
+{
+    task->kernel_stack = kzalloc(MAEROS_KERNEL_STACK_SIZE);
+    if (!task->kernel_stack)
+    {
+        return -ENOMEM;
+    }
+
+    uint32_t* stack = (uint32_t*)((uint32_t) task->kernel_stack + MAEROS_KERNEL_STACK_SIZE);
+
+    // task_entry never returns, the return address is just a placeholder
+    *--stack = 0;
+    *--stack = (uint32_t) task_entry;
+
+    // ebp, ebx, esi and edi popped by task_context_switch
+    *--stack = 0;
+    *--stack = 0;
+    *--stack = 0;
+    *--stack = 0;
+
+    task->kernel_esp = (uint32_t) stack;
+    return 0;
+}
+
+/** @brief create a kernel thread which is not in the run queue yet */
+static struct task* task_create_kernel(KERNEL_THREAD_FUNCTION function, void* data)
+{
+    int res = 0;
+    struct task* task = kzalloc(sizeof(struct task));
+    if (!task)
+    {
+        res = -ENOMEM;
+        goto out;
+    }
+
+    res = task_init_kernel_stack(task);
+    if (res < 0)
+    {
+        goto out;
+    }
+
+    task->page_directory = kernel_paging_chunk();
+    task->cpu = cpu_current();
+    task->kernel_function = function;
+    task->kernel_data = data;
+    task->registers.cs = KERNEL_CODE_SELECTOR;
+    task->registers.ss = KERNEL_DATA_SELECTOR;
+    task->state = TASK_STATE_RUNNABLE;
+
+out:
+    if (ISERR(res))
+    {
+        if (task)
+        {
+            if (task->kernel_stack)
+            {
+                kfree(task->kernel_stack);
+            }
+            kfree(task);
+        }
+        return ERROR(res);
+    }
+
+    return task;
+}
+
+struct task* task_new_kernel(KERNEL_THREAD_FUNCTION function, void* data)
+{
+    struct task* task = task_create_kernel(function, data);
+    if (!ISERR(task))
+    {
+        task_enqueue(task);
+    }
+
+    return task;
+}
+
+/** @brief work item freeing an exited kernel thread */
+static void task_kernel_reclaim(struct work* work)
+{
+    task_free(work->data);
+}
+
+void task_exit_kernel()
+{
+    // The thread must not be moved to another CPU while it looks itself up
+    disable_interrupts();
+
+    struct task* task = task_current();
+    if (!task || !task_is_kernel(task) || task_is_idle(task))
+    {
+        panic("task_exit_kernel(): Current task is not a kernel thread\n");
+    }
+
+    task_stop(task);
+
+    /* we still run on the stack of the thread, it is freed by the worker
+    once we switched away from it */
+    work_init(&task->reclaim_work, task_kernel_reclaim, task);
+    workqueue_schedule(&task->reclaim_work);
+
+    /* notice that we never return from here */
+    task_next();
+}
+
+/** @brief create the idle task, it is a kernel thread which is never in the run queue */
+void task_idle_init(struct cpu* cpu)
+{
+    struct task* task = task_create_kernel(task_idle, 0);
+    if (ISERR(task))
+    {
+        panic("task_idle_init(): Failed to create the idle task\n");
+    }
+
+    task->cpu = cpu;
+    cpu->run_queue.idle = task;
+}
+
+bool task_is_idle(struct task* task)
+{
+    return task && task == task->cpu->run_queue.idle;
+}
+
+bool task_is_kernel(struct task* task)
+{
+    return task->registers.cs == KERNEL_CODE_SELECTOR;
+}
+
+bool task_quantum_expired()
+{
+    return (int32_t)(timer_ticks() - task_run_queue()->quantum_end) >= 0;
+}
+
+void task_program_timer()
+{
+    struct cpu* cpu = cpu_current();
+    struct run_queue* queue = &cpu->run_queue;
+
+    /* a time slice only needs to end if another task waits in the run queue */
+    bool has_quantum = queue->current && !task_is_idle(queue->current) && task_others_runnable(queue);
+    cpu_program_timer(cpu, has_quantum, queue->quantum_end);
+}
+
+uint32_t task_total_ticks()
+{
+    int started = 0;
+    for (int i = 0; i < smp_cpu_count(); i++)
+    {
+        if (cpu_get(i)->started)
+        {
+            started++;
+        }
+    }
+
+    return timer_ticks() * started;
+}
+
+uint32_t task_idle_ticks()
+{
+    uint64_t cycles = 0;
+    for (int i = 0; i < smp_cpu_count(); i++)
+    {
+        struct run_queue* queue = &cpu_get(i)->run_queue;
+        cycles += queue->idle_cycles;
+        if (task_is_idle(queue->current))
+        {
+            cycles += tsc_read() - queue->idle_since;
+        }
+    }
+
+    return (uint32_t) div64(cycles, clock_tsc_per_tick());
+}
+
+/** @brief changing current/running task, by switching to its kernel stack
+ * @note the page directory is not changed, kernel code always runs on the kernel page
+ * directory and task_page loads the one of the task when it returns to user land
+*/
 int task_switch(struct task *task)
 {
-    current_task = task;
-    paging_switch(task->page_directory);
+    struct cpu* cpu = cpu_current();
+    struct run_queue* queue = &cpu->run_queue;
+    struct task* prev = queue->current;
+
+    // New time slice starts
+    queue->quantum_end = timer_ticks() + MAEROS_TASK_QUANTUM_TICKS;
+
+    if (task == prev)
+    {
+        task_program_timer();
+        return 0;
+    }
+
+    // CPU utilisation accounting, count how long the CPU stays idle
+    if (task_is_idle(prev))
+    {
+        queue->idle_cycles += tsc_read() - queue->idle_since;
+    }
+    if (task_is_idle(task))
+    {
+        queue->idle_since = tsc_read();
+    }
+
+    queue->current = task;
+    task_program_timer();
+
+    /* the previous task may belong to a terminated process, its memory is freed once no CPU
+    runs it. The worker freeing it needs the big kernel lock, we hold it until the switch is done */
+    if (prev)
+    {
+        process_task_switched_out(prev);
+    }
+
+    // The FPU registers are switched lazily, on the first FPU instruction of the task
+    fpu_switch(cpu, prev);
+
+    // gs of the task points at its own thread area
+    cpu_set_tls_base(cpu, task->tls_base);
+
+    // The CPU enters the kernel on the stack of the task from now on
+    cpu->tss.esp0 = (uint32_t) task->kernel_stack + MAEROS_KERNEL_STACK_SIZE;
+
+    if (!prev)
+    {
+        /* notice that we never come back, the boot stack is left behind */
+        task_context_switch(&queue->boot_esp, task->kernel_esp);
+        return 0;
+    }
+
+    /* the big kernel lock is handed over to the next task, the depth of this task is
+    restored when it runs again, maybe on another CPU */
+    prev->kernel_lock_depth = cpu->kernel_lock_depth;
+
+    // We come back here when the previous task is switched to again
+    task_context_switch(&prev->kernel_esp, task->kernel_esp);
+
+    cpu_current()->kernel_lock_depth = prev->kernel_lock_depth;
     return 0;
 }
 
@@ -147,57 +765,118 @@ void task_save_state(struct task *task, struct interrupt_frame *frame)
     task->registers.esi = frame->esi;
 }
 
-/** @brief Copy string from task. We unfortunately cannot access from kernel land directly 
- * because the virtual address will be mapped in the process address range.
- * i.e. 'virtual' may be 0x400015 points to physical address (we do not know at first)
- * We can not copy from 0x400015 because all processes share same address as virtual
- * 
- * we create a shared memory 'tmp' in kernel.
- * It is used for copying strings between task and kernel
- * 
- * @retval return string via 'phys'
- * */
-int copy_string_from_task(struct task* task, void* virtual, void* phys, int max)
+/** @brief the kernel address of the byte at the user address 'virtual' of the task, the
+ * page tables are walked by hand, so the task directory does not have to be loaded
+ * @retval zero if the page is not accessible from user land, or not writeable when 'write' is set
+*/
+static uint8_t* task_user_address(struct task* task, uint32_t virtual, bool write)
+{
+    uint32_t required = PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL;
+    if (write)
+    {
+        required |= PAGING_IS_WRITEABLE;
+    }
+
+    // The CPU checks the directory entry as well as the table entry, both must allow it
+    uint32_t directory_entry = task->page_directory->directory_entry[virtual / (PAGING_TOTAL_ENTRIES_PER_TABLE * PAGING_PAGE_SIZE)];
+    if ((directory_entry & required) != required)
+    {
+        return 0;
+    }
+
+    uint32_t* table = (uint32_t*)(directory_entry & 0xfffff000);
+    uint32_t entry = table[virtual / PAGING_PAGE_SIZE % PAGING_TOTAL_ENTRIES_PER_TABLE];
+    if ((entry & required) != required)
+    {
+        return 0;
+    }
+
+    return (uint8_t*)((entry & 0xfffff000) + virtual % PAGING_PAGE_SIZE);
+}
+
+/** @brief copy between a kernel buffer and user memory, a page at a time since the pages of
+ * the task are not contiguous in physical memory */
+static int task_copy_user(struct task* task, uint8_t* kernel, uint32_t user, size_t size, bool to_user)
 {
-    if (max >= PAGING_PAGE_SIZE)
+    // The user range must not wrap around the address space
+    if (user + size < user)
     {
         return -EINVARG;
     }
 
-    int res = 0;
-    char* tmp = kzalloc(max);
-    if (!tmp)
+    while (size)
     {
-        res = -ENOMEM;
-        goto out;
+        uint8_t* page = task_user_address(task, user, to_user);
+        if (!page)
+        {
+            return -EINVARG;
+        }
+
+        size_t chunk = PAGING_PAGE_SIZE - user % PAGING_PAGE_SIZE;
+        if (chunk > size)
+        {
+            chunk = size;
+        }
+
+        if (to_user)
+        {
+            memcpy(page, kernel, chunk);
+        }
+        else
+        {
+            memcpy(kernel, page, chunk);
+        }
+
+        kernel += chunk;
+        user += chunk;
+        size -= chunk;
     }
 
-    /* task page directory */
-    uint32_t* task_directory = task->page_directory->directory_entry;
-    uint32_t old_entry = paging_get(task_directory, tmp);
+    return 0;
+}
 
-    /* map the virtual address temp to physical address temp for that task */
-    paging_map(task->page_directory, tmp, tmp, PAGING_IS_WRITEABLE | PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
-    
+int copy_from_user(struct task* task, void* dst, const void* user_src, size_t size)
+{
+    return task_copy_user(task, dst, (uint32_t) user_src, size, false);
+}
 
-    paging_switch(task->page_directory);
-    strncpy(tmp, virtual, max);
-    kernel_page();
+int copy_to_user(struct task* task, void* user_dst, const void* src, size_t size)
+{
+    return task_copy_user(task, (uint8_t*) src, (uint32_t) user_dst, size, true);
+}
 
-    /* restore task old state (old paging table)*/
-    res = paging_set(task_directory, tmp, old_entry);
-    if (res < 0)
+int strncpy_from_user(struct task* task, char* dst, const void* user_src, int max)
+{
+    if (max <= 0)
     {
-        res = -EIO;
-        goto out_free;
+        return -EINVARG;
     }
 
-    strncpy(phys, tmp, max);
+    uint32_t user = (uint32_t) user_src;
+    int len = 0;
+    while (len < max - 1)
+    {
+        // The page is looked up again only when the string crosses into the next one
+        uint8_t* page = task_user_address(task, user, false);
+        if (!page)
+        {
+            dst[len] = 0;
+            return -EINVARG;
+        }
+
+        int page_left = PAGING_PAGE_SIZE - user % PAGING_PAGE_SIZE;
+        for (int i = 0; i < page_left && len < max - 1; i++, len++, user++)
+        {
+            dst[len] = page[i];
+            if (!page[i])
+            {
+                return len;
+            }
+        }
+    }
 
-out_free:
-    kfree(tmp);
-out:
-    return res;
+    dst[len] = 0;
+    return len;
 }
 
 void task_current_save_state(struct interrupt_frame *frame)
@@ -214,14 +893,27 @@ void task_current_save_state(struct interrupt_frame *frame)
 
 int task_page()
 {
-    user_registers();
-    task_switch(current_task);
-    return 0;
+    struct task* task = task_current();
+    if (!task)
+    {
+        /* current task is removed and the next one is not picked yet */
+        return 0;
+    }
+
+    return task_page_task(task);
 }
 
 int task_page_task(struct task* task)
 {
+    if (task_is_kernel(task))
+    {
+        kernel_registers();
+        paging_switch(task->page_directory);
+        return 0;
+    }
+
     user_registers();
+    vdso_update(task);
     paging_switch(task->page_directory);
     return 0;
 }
@@ -229,13 +921,21 @@ int task_page_task(struct task* task)
 /** @brief runs first(initial) task */
 void task_run_first_ever_task()
 {
-    if (!current_task)
+    struct run_queue* queue = task_run_queue();
+    if (!queue->head)
     {
         panic("task_run_first_ever_task(): No current task exists!\n");
     }
 
-    task_switch(task_head);
-    task_return(&task_head->registers);
+    task_scheduler_running = true;
+
+    /* notice that we never return from here, the boot stack is left behind */
+    task_switch(queue->head);
+}
+
+void task_run_idle()
+{
+    task_switch(task_run_queue()->idle);
 }
 
 /** @brief initialize a task by creating page table directory for the task*/
@@ -268,31 +968,7 @@ int task_init(struct task *task, struct process *process)
     task->registers.esp = MAEROS_PROGRAM_VIRTUAL_STACK_ADDRESS_START;
 
     task->process = process;
+    task->state = TASK_STATE_RUNNABLE;
 
     return 0;
 }
-
-void* task_get_stack_item(struct task* task, int index)
-{
-    void* result = 0;
-
-    /* task registers are filled via function call 'task_save_state' */
-    
-    /* we grab the stack pointer for given task */
-    uint32_t* sp_ptr = (uint32_t*) task->registers.esp;
-
-    // Switch to the given tasks page
-    task_page_task(task);
-
-    result = (void*) sp_ptr[index];
-
-    // Switch back to the kernel page
-    kernel_page();
-
-    return result;
-}
-
-void* task_virtual_address_to_physical(struct task* task, void* virtual_address)
-{
-    return paging_get_physical_address(task->page_directory->directory_entry, virtual_address);
-}
\ No newline at end of file
@@ -1,8 +1,13 @@
 #ifndef TASK_H
 #define TASK_H
 
+#include <stdint.h>
+#include <stdbool.h>
+
 #include "config.h"
 #include "memory/paging/paging.h"
+#include "timer/timer.h"
+#include "workqueue.h"
 
 struct interrupt_frame;
 
@@ -30,6 +35,51 @@ struct registers
 
 
 struct process;
+struct wait_queue;
+struct cpu;
+
+
+/** @brief Scheduling state of a task */
+typedef unsigned char TASK_STATE;
+enum
+{
+    /** @brief The task is in the run queue and it can be picked by the scheduler */
+    TASK_STATE_RUNNABLE,
+    /** @brief The task sleeps on a wait queue, it is out of the run queue */
+    TASK_STATE_BLOCKED,
+    /** @brief The task is stopped for good, it is only waiting to be freed */
+    TASK_STATE_DEAD
+};
+
+/** @brief body of a kernel thread, the thread exits when the function returns */
+typedef void (*KERNEL_THREAD_FUNCTION)(void* data);
+
+/** @brief The tasks of a CPU, every CPU schedules its own run queue (see smp.h) */
+struct run_queue
+{
+    /** @brief The task the CPU runs, it is at the head of the queue while it is runnable */
+    struct task* current;
+
+    /** @brief The idle task of the CPU, it is never in the queue and it only runs when no
+     * task is runnable */
+    struct task* idle;
+
+    struct task* head;
+    struct task* tail;
+
+    /** @brief number of tasks in the queue */
+    int count;
+
+    /** @brief The tick at which the time slice of the current task ends */
+    uint32_t quantum_end;
+
+    /** @brief TSC cycles spent in the idle task, and when the idle task was switched to last time */
+    uint64_t idle_cycles;
+    uint64_t idle_since;
+
+    /** @brief where the boot stack pointer goes when the first task is switched to, it is never used again */
+    uint32_t boot_esp;
+};
 
 /** @brief Task structure */
 struct task
@@ -43,22 +93,120 @@ struct task
     /** @brief The process of the task */
     struct process* process;
 
-    /** @brief The next task in the linked list */
+    /** @brief The task is an extra thread of its process, the page directory belongs to the
+     * main task of the process and it is not freed with this task */
+    bool is_thread;
+
+    /** @brief Whether the task is runnable or blocked */
+    TASK_STATE state;
+
+    /** @brief The wait queue the task sleeps on while it is blocked */
+    struct wait_queue* wait_queue;
+
+    /** @brief The next task sleeping on the same wait queue */
+    struct task* wait_next;
+
+    /** @brief The timer that wakes the task up when it sleeps for some time */
+    struct timer sleep_timer;
+
+    /** @brief The kernel stack of the task, the CPU switches to it (tss.esp0) when the task
+     * enters the kernel. Kernel threads run on it all the time */
+    void* kernel_stack;
+
+    /** @brief The kernel stack pointer saved by task_context_switch while the task is not running */
+    uint32_t kernel_esp;
+
+    /** @brief The body of a kernel thread and its argument */
+    KERNEL_THREAD_FUNCTION kernel_function;
+    void* kernel_data;
+
+    /** @brief Frees the task after it exited, it can not free its own stack */
+    struct work reclaim_work;
+
+    /** @brief The CPU whose run queue the task is in, it changes when the task is stolen */
+    struct cpu* cpu;
+
+    /** @brief how many times the task holds the big kernel lock while it is switched out */
+    int kernel_lock_depth;
+
+    /** @brief The base of the user TLS segment (gs) of the task, see set_thread_area */
+    uint32_t tls_base;
+
+    /** @brief The FXSAVE area of the task, it is allocated when the task uses the FPU first */
+    void* fpu_state;
+
+    /** @brief The CPU the FPU registers of the task were loaded into last time (see fpu.h) */
+    struct cpu* fpu_cpu;
+
+    /** @brief The next task in the run queue (linked list) */
     struct task* next;
 
-    /** @brief Previous task in the linked list */
+    /** @brief Previous task in the run queue (linked list) */
     struct task* prev;
 };
 
 /** @brief create a new task */
 struct task* task_new(struct process* process);
 
+/** @brief create another thread of 'process', it shares the page directory of the main task
+ * and it starts in user land at 'ip' with the stack pointer 'esp'
+*/
+struct task* task_new_thread(struct process* process, uint32_t ip, uint32_t esp);
+
+/** @brief create a kernel thread, a ring 0 task without a user address space which runs
+ * 'function' on a stack of its own. It is put into the run queue like any other task.
+*/
+struct task* task_new_kernel(KERNEL_THREAD_FUNCTION function, void* data);
+
+/** @brief stop the current kernel thread, its memory is freed later by the kernel work queue */
+void task_exit_kernel();
+
+/** @brief run 'task' right after the current task, i.e. a program that has just been loaded,
+ * then switch to it. It returns when the current task is picked again.
+*/
+void task_yield_to(struct task* task);
+
+/** @brief a preemption point for long running kernel code (i.e. loading a process).
+ * Pending interrupts are handled and the current task is switched out if its time slice
+ * is used up, so a long syscall does not hold the CPU.
+ * @note it must be called with interrupts disabled, without holding anything that an
+ * interrupt handler or another task could use meanwhile other than through a mutex
+*/
+void task_preempt_point();
+
+/** @brief take the task out of scheduling for good, i.e. its process is terminated.
+ * The task stays allocated until task_free is called. If another CPU runs it, that CPU is
+ * interrupted and switches away from it (see task_leave_if_dead).
+*/
+void task_stop(struct task* task);
+
+
 struct task* task_current();
 struct task* task_get_next();
 int task_free(struct task* task);
 
 int task_switch(struct task* task);
 
+/** @brief take the task out of the run queue, the scheduler skips it until it is unblocked */
+void task_block(struct task* task);
+
+/** @brief put a blocked task back into the run queue */
+void task_unblock(struct task* task);
+
+/** @brief block the current task for 'ms' milliseconds and run the other tasks meanwhile,
+ * it returns when the task is woken up by the timer
+*/
+void task_sleep(uint32_t ms);
+
+/** @brief check whether the time slice of the current task is used up */
+bool task_quantum_expired();
+
+/** @brief program the one-shot timer interrupt for the next kernel timer or the end of the
+ * time slice of the current task. It must be called before returning to a task, since the
+ * run queue may have changed.
+*/
+void task_program_timer();
+
 /** @brief Task page takes us out of the kernel page directory and 
  * loads us into the task page directory.*/
 int task_page();
@@ -66,9 +214,17 @@ int task_page_task(struct task* task);
 
 void task_run_first_ever_task();
 
+/** @brief run the idle task of an AP for the first time, it never returns */
+void task_run_idle();
+
 /** @brief the function will drop us into userland, also changes all CPU registers */
 void task_return(struct registers* regs);
 
+/** @brief save the callee-saved registers and the stack pointer to 'prev_esp' and continue
+ * on the kernel stack 'next_esp'. It returns when the previous task is switched back to.
+*/
+void task_context_switch(uint32_t* prev_esp, uint32_t next_esp);
+
 /** @brief restore general purpose registers in assembly */
 void restore_general_purpose_registers(struct registers* regs);
 void user_registers();
@@ -76,13 +232,45 @@ void user_registers();
 /** @brief Save the current task state (registers) */
 void task_current_save_state(struct interrupt_frame *frame);
 
-int copy_string_from_task(struct task* task, void* virtual, void* phys, int max);
+/** @brief copy 'size' bytes from the user address 'user_src' of the task to 'dst'
+ * @note the page tables of the task are walked page by page and the bytes are copied from
+ * the physical frames, the page directory is not switched
+ * @retval 0, or -EINVARG if some of the user memory is not accessible from user land
+*/
+int copy_from_user(struct task* task, void* dst, const void* user_src, size_t size);
+
+/** @brief copy 'size' bytes from 'src' to the user address 'user_dst' of the task
+ * @retval 0, or -EINVARG if some of the user memory is not writeable from user land
+*/
+int copy_to_user(struct task* task, void* user_dst, const void* src, size_t size);
 
-/** @brief Read an 'index'th item (arguments) from the stack */
-void* task_get_stack_item(struct task* task, int index);
-/** @brief It will take the virtual address the user space provided us and 
- * it will convert it to a physical address*/
-void* task_virtual_address_to_physical(struct task* task, void* virtual_address);
+/** @brief copy a string from the user address 'user_src' of the task to 'dst', at most 'max'
+ * bytes including the terminating zero. 'dst' is always terminated.
+ * @retval the length of the string copied, or -EINVARG if the user memory is not accessible
+*/
+int strncpy_from_user(struct task* task, char* dst, const void* user_src, int max);
+
+/** @brief switch away from the current task if it is stopped, i.e. another CPU terminated
+ * its process meanwhile. It is called on the way back to user land and at the preemption
+ * points, it never returns for a stopped task.
+*/
+void task_leave_if_dead();
+
+/** @brief switch to the next task in the run queue, the current task goes to the end of
+ * the queue if it is still runnable. It returns when the current task is picked again,
+ * a blocked task returns once it is woken up, a stopped task never returns.
+*/
 void task_next();
 
+/** @brief create the idle task of the CPU which halts it when no task is runnable */
+void task_idle_init(struct cpu* cpu);
+bool task_is_idle(struct task* task);
+/** @brief check the task runs in kernel mode (ring 0) */
+bool task_is_kernel(struct task* task);
+
+/** @brief number of timer ticks since boot, summed over the CPUs */
+uint32_t task_total_ticks();
+/** @brief number of timer ticks spent in the idle tasks of the CPUs */
+uint32_t task_idle_ticks();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,63 @@
+#include "vdso.h"
+#include "task.h"
+#include "process.h"
+#include "config.h"
+#include "status.h"
+#include "memory/heap/kheap.h"
+#include "memory/paging/paging.h"
+#include "timer/clock.h"
+#include "smp/smp.h"
+
+int vdso_map(struct process* process)
+{
+    // A heap block is a page, nothing else of the kernel is visible through the mapping
+    struct vdso_data* vdso = kzalloc(PAGING_PAGE_SIZE);
+    if (!vdso)
+    {
+        return -ENOMEM;
+    }
+
+    vdso->pid = process->id;
+    vdso->cpu_count = smp_cpu_count();
+    vdso->timer_hz = MAEROS_TIMER_HZ;
+    vdso->tsc_per_ms = clock_tsc_khz();
+    vdso->tsc_per_tick = clock_tsc_per_tick();
+    vdso->tsc_boot = clock_tsc_boot();
+    vdso->ticks = clock_ticks();
+
+    int res = paging_map(process->task->page_directory, (void*) MAEROS_VDSO_VIRTUAL_ADDRESS, vdso, PAGING_IS_PRESENT | PAGING_ACCESS_FROM_ALL);
+    if (res < 0)
+    {
+        kfree(vdso);
+        return res;
+    }
+
+    process->vdso = vdso;
+    return 0;
+}
+
+void vdso_free(struct process* process)
+{
+    if (process->vdso)
+    {
+        kfree(process->vdso);
+    }
+}
+
+void vdso_update(struct task* task)
+{
+    struct vdso_data* vdso = task->process->vdso;
+    if (vdso)
+    {
+        vdso->cpu = cpu_current()->id;
+    }
+}
+
+void vdso_tick()
+{
+    struct task* task = task_current();
+    if (task && !task_is_kernel(task) && task->process->vdso)
+    {
+        task->process->vdso->ticks = clock_ticks();
+    }
+}
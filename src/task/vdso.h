@@ -0,0 +1,46 @@
+#ifndef VDSO_H
+#define VDSO_H
+
+#include <stdint.h>
+
+/** @file vdso.h
+ * @brief A read-only page every process sees at MAEROS_VDSO_VIRTUAL_ADDRESS. It holds what a
+ * program would otherwise need a syscall for: its process id, the CPU it runs on and the TSC
+ * calibration of the clocksource, so the stdlib computes the uptime from the TSC alone.
+ * @note the page belongs to the process, its threads share it
+*/
+
+struct process;
+struct task;
+
+struct vdso_data
+{
+    uint32_t pid;
+
+    /** @brief the CPU a thread of the process last returned to user land on */
+    uint32_t cpu;
+    uint32_t cpu_count;
+
+    /** @brief the tick count when the timer interrupt last came from the process, the time
+     * computed from tsc_boot and the TSC is exact */
+    uint32_t ticks;
+    uint32_t timer_hz;
+
+    /** @brief the clocksource, time zero and TSC cycles per millisecond and per tick */
+    uint32_t tsc_per_ms;
+    uint32_t tsc_per_tick;
+    uint64_t tsc_boot;
+};
+
+/** @brief allocate the page of the process and map it read-only into its address space */
+int vdso_map(struct process* process);
+
+void vdso_free(struct process* process);
+
+/** @brief refresh the page of the task's process, it is called on the way back to user land */
+void vdso_update(struct task* task);
+
+/** @brief refresh the tick count of the current process, called by the timer interrupt */
+void vdso_tick();
+
+#endif
@@ -0,0 +1,94 @@
+#include "waitqueue.h"
+#include "task.h"
+#include "kernel.h"
+
+void wait_queue_init(struct wait_queue* queue)
+{
+    queue->head = 0;
+    queue->tail = 0;
+}
+
+/** @brief append the task to the end of the queue */
+static void wait_queue_add(struct wait_queue* queue, struct task* task)
+{
+    task->wait_queue = queue;
+    task->wait_next = 0;
+
+    if (queue->tail)
+    {
+        queue->tail->wait_next = task;
+        queue->tail = task;
+        return;
+    }
+
+    queue->head = task;
+    queue->tail = task;
+}
+
+void wait_queue_remove(struct task* task)
+{
+    struct wait_queue* queue = task->wait_queue;
+    if (!queue)
+    {
+        return;
+    }
+
+    struct task* prev = 0;
+    struct task* current = queue->head;
+    while(current && current != task)
+    {
+        prev = current;
+        current = current->wait_next;
+    }
+
+    if (current)
+    {
+        if (prev)
+        {
+            prev->wait_next = task->wait_next;
+        }
+        else
+        {
+            queue->head = task->wait_next;
+        }
+
+        if (queue->tail == task)
+        {
+            queue->tail = prev;
+        }
+    }
+
+    task->wait_queue = 0;
+    task->wait_next = 0;
+}
+
+void wait_queue_sleep(struct wait_queue* queue)
+{
+    struct task* task = task_current();
+    if (!task)
+    {
+        panic("wait_queue_sleep(): No current task to block\n");
+    }
+
+    wait_queue_add(queue, task);
+    task_block(task);
+
+    // We are back here once the task is woken up
+    task_next();
+}
+
+void wake_up(struct wait_queue* queue)
+{
+    struct task* task = queue->head;
+    queue->head = 0;
+    queue->tail = 0;
+
+    while(task)
+    {
+        struct task* next = task->wait_next;
+        task->wait_queue = 0;
+        task->wait_next = 0;
+        task_unblock(task);
+        task = next;
+    }
+}
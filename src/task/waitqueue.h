@@ -0,0 +1,44 @@
+#ifndef WAITQUEUE_H
+#define WAITQUEUE_H
+
+/** @file waitqueue.h
+ * @brief A wait queue is a list of tasks sleeping until some condition becomes true,
+ * i.e. a key is pressed. Sleeping tasks are taken out of the run queue so the scheduler
+ * does not give them any CPU time until somebody wakes them up.
+*/
+
+struct task;
+
+/** @brief FIFO list of blocked tasks, linked through task->wait_next */
+struct wait_queue
+{
+    struct task* head;
+    struct task* tail;
+};
+
+void wait_queue_init(struct wait_queue* queue);
+
+/** @brief remove the task from the wait queue it sleeps on (i.e. process is killed while waiting) */
+void wait_queue_remove(struct task* task);
+
+/** @brief block the current task on the queue and run the other tasks meanwhile,
+ * it returns once the task is woken up
+*/
+void wait_queue_sleep(struct wait_queue* queue);
+
+/** @brief wake every task sleeping on the queue and put them back into the run queue */
+void wake_up(struct wait_queue* queue);
+
+/** @brief sleep on the queue until 'condition' is true, the condition is checked again
+ * every time the task is woken up
+*/
+#define wait_event(queue, condition)        \
+    do                                      \
+    {                                       \
+        while (!(condition))                \
+        {                                   \
+            wait_queue_sleep(queue);        \
+        }                                   \
+    } while(0)
+
+#endif
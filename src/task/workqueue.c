@@ -0,0 +1,101 @@
+#include "workqueue.h"
+#include "task.h"
+#include "kernel.h"
+#include "status.h"
+#include "idt/idt.h"
+
+/** @brief the work queue shared by the whole kernel, i.e. to free exited tasks */
+static struct workqueue kernel_workqueue;
+
+void work_init(struct work* work, WORK_FUNCTION function, void* data)
+{
+    work->function = function;
+    work->data = data;
+    work->queued = false;
+    work->next = 0;
+}
+
+/** @brief take the first item out of the queue */
+static struct work* workqueue_pop(struct workqueue* queue)
+{
+    struct work* work = queue->head;
+    queue->head = work->next;
+    if (!queue->head)
+    {
+        queue->tail = 0;
+    }
+
+    work->next = 0;
+    work->queued = false;
+    return work;
+}
+
+/** @brief body of the worker thread */
+static void workqueue_worker(void* data)
+{
+    struct workqueue* queue = data;
+    while(1)
+    {
+        disable_interrupts();
+        wait_event(&queue->wait, queue->head != 0);
+
+        struct work* work = workqueue_pop(queue);
+        work->function(work);
+
+        // The worker can be preempted between the items
+        enable_interrupts();
+    }
+}
+
+int workqueue_init(struct workqueue* queue)
+{
+    int res = 0;
+    queue->head = 0;
+    queue->tail = 0;
+    wait_queue_init(&queue->wait);
+
+    queue->worker = task_new_kernel(workqueue_worker, queue);
+    if (ISERR(queue->worker))
+    {
+        res = ERROR_I(queue->worker);
+        queue->worker = 0;
+    }
+
+    return res;
+}
+
+bool workqueue_queue(struct workqueue* queue, struct work* work)
+{
+    if (work->queued)
+    {
+        return false;
+    }
+
+    work->queued = true;
+    work->next = 0;
+    if (queue->tail)
+    {
+        queue->tail->next = work;
+    }
+    else
+    {
+        queue->head = work;
+    }
+    queue->tail = work;
+
+    wake_up(&queue->wait);
+    return true;
+}
+
+void workqueue_kernel_init()
+{
+    if (workqueue_init(&kernel_workqueue) < 0)
+    {
+        panic("workqueue_kernel_init(): Failed to create the kernel worker\n");
+    }
+}
+
+bool workqueue_schedule(struct work* work)
+{
+    return workqueue_queue(&kernel_workqueue, work);
+}
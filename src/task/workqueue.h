@@ -0,0 +1,65 @@
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include <stdbool.h>
+
+#include "waitqueue.h"
+
+/** @file workqueue.h
+ * @brief A work queue defers a job out of an interrupt handler or a syscall. The job
+ * (work item) is queued and returns immediately, a kernel thread (the worker) runs the
+ * queued items one by one later on, when the scheduler picks it like any other task.
+ *
+ * Kernel code is not reentrant, so the worker runs each item with interrupts disabled
+ * exactly like a syscall runs. Interrupts are enabled between the items, therefore the
+ * worker can be preempted and the time spent in deferred work is shared fairly.
+*/
+
+struct work;
+struct task;
+
+/** @brief function a work item runs in the worker thread */
+typedef void (*WORK_FUNCTION)(struct work* work);
+
+struct work
+{
+    WORK_FUNCTION function;
+
+    /** @brief private data of the owner of the work item */
+    void* data;
+
+    /** @brief whether the item waits in a queue, it is not queued twice */
+    bool queued;
+
+    struct work* next;
+};
+
+/** @brief FIFO of work items and the kernel thread running them */
+struct workqueue
+{
+    struct work* head;
+    struct work* tail;
+
+    /** @brief the worker sleeps here while the queue is empty */
+    struct wait_queue wait;
+
+    struct task* worker;
+};
+
+void work_init(struct work* work, WORK_FUNCTION function, void* data);
+
+/** @brief initialize the queue and start its worker thread */
+int workqueue_init(struct workqueue* queue);
+
+/** @brief queue the work item and wake the worker up, it can be called from an interrupt handler
+ * @retval false if the item is already queued
+*/
+bool workqueue_queue(struct workqueue* queue, struct work* work);
+
+/** @brief create the kernel work queue shared by the whole kernel */
+void workqueue_kernel_init();
+
+/** @brief queue the work item to the kernel work queue */
+bool workqueue_schedule(struct work* work);
+
+#endif
@@ -0,0 +1,73 @@
+#include "clock.h"
+#include "div64.h"
+#include "pit.h"
+#include "config.h"
+
+/** @brief TSC value taken as the time zero */
+static uint64_t clock_tsc_boot_cycles = 0;
+
+/** @brief TSC cycles per millisecond */
+static uint32_t clock_tsc_cycles_per_ms = 0;
+
+/** @brief TSC cycles per timer tick */
+static uint32_t clock_tsc_cycles_per_tick = 0;
+
+void clock_init()
+{
+    /* count the TSC cycles while the PIT (whose frequency is known) counts down 10ms */
+    pit_channel2_start(PIT_FREQUENCY / 1000 * CLOCK_CALIBRATION_MS);
+    uint64_t start = tsc_read();
+    while(!pit_channel2_expired())
+    {
+    }
+    uint64_t end = tsc_read();
+
+    clock_tsc_cycles_per_ms = (uint32_t)(end - start) / CLOCK_CALIBRATION_MS;
+    clock_tsc_cycles_per_tick = clock_tsc_cycles_per_ms * (1000 / MAEROS_TIMER_HZ);
+    clock_tsc_boot_cycles = tsc_read();
+}
+
+uint64_t clock_tsc_boot()
+{
+    return clock_tsc_boot_cycles;
+}
+
+uint32_t clock_tsc_per_tick()
+{
+    return clock_tsc_cycles_per_tick;
+}
+
+uint32_t clock_tsc_khz()
+{
+    return clock_tsc_cycles_per_ms;
+}
+
+uint32_t clock_ticks()
+{
+    return (uint32_t) div64(tsc_read() - clock_tsc_boot_cycles, clock_tsc_cycles_per_tick);
+}
+
+uint32_t clock_uptime_ms()
+{
+    return (uint32_t) div64(tsc_read() - clock_tsc_boot_cycles, clock_tsc_cycles_per_ms);
+}
+
+uint64_t clock_cycles_until(uint32_t tick)
+{
+    uint64_t target = clock_tsc_boot_cycles + (uint64_t) tick * clock_tsc_cycles_per_tick;
+    uint64_t now = tsc_read();
+    if (target <= now)
+    {
+        return 0;
+    }
+
+    return target - now;
+}
+
+void clock_delay_us(uint32_t us)
+{
+    uint64_t end = tsc_read() + div64((uint64_t) us * clock_tsc_cycles_per_ms, 1000);
+    while(tsc_read() < end)
+    {
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <stdint.h>
+
+/** @file clock.h
+ * @brief The clocksource keeps the time without needing the timer interrupt. It is based on
+ * the time stamp counter (TSC) of the CPU which is calibrated against the PIT at boot,
+ * therefore the timer interrupt can be stopped while nothing needs it (tickless).
+*/
+
+/** @brief how long the TSC is measured against the PIT during calibration */
+#define CLOCK_CALIBRATION_MS 10
+
+/** @brief calibrate the TSC and take the current time as zero */
+void clock_init();
+
+/** @brief read the time stamp counter (in asm file) */
+uint64_t tsc_read();
+
+/** @brief the TSC value taken as time zero */
+uint64_t clock_tsc_boot();
+
+/** @brief TSC cycles per timer tick */
+uint32_t clock_tsc_per_tick();
+
+/** @brief TSC frequency measured at boot in kHz */
+uint32_t clock_tsc_khz();
+
+/** @brief timer ticks (1 / MAEROS_TIMER_HZ seconds) since boot */
+uint32_t clock_ticks();
+
+/** @brief milliseconds since boot */
+uint32_t clock_uptime_ms();
+
+/** @brief TSC cycles left until the given tick starts, zero if it is already reached */
+uint64_t clock_cycles_until(uint32_t tick);
+
+/** @brief busy wait for 'us' microseconds, i.e. between the IPIs starting a CPU */
+void clock_delay_us(uint32_t us);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef TIMER_DIV64_H
+#define TIMER_DIV64_H
+
+/** @file div64.h
+ * @brief Division of a 64 bit number by a 32 bit number. Neither the kernel nor the programs
+ * link libgcc, so the '/' operator cannot be used on 64 bit numbers. The header is shared
+ * with the programs (see syscalls.h), so it uses the C types only.
+*/
+
+/** @brief 'dividend' / 'divisor', one bit of the quotient at a time */
+static inline unsigned long long div64(unsigned long long dividend, unsigned int divisor)
+{
+    unsigned long long quotient = 0;
+    unsigned long long remainder = 0;
+    for (int i = 63; i >= 0; i--)
+    {
+        remainder = (remainder << 1) | ((dividend >> i) & 1);
+        if (remainder >= divisor)
+        {
+            remainder -= divisor;
+            quotient |= (1ULL << i);
+        }
+    }
+
+    return quotient;
+}
+
+#endif
@@ -0,0 +1,74 @@
+#include "pit.h"
+#include "clock.h"
+#include "div64.h"
+#include "io/io.h"
+
+static uint64_t pit_max_cycles();
+static void pit_program(uint64_t cycles);
+
+static struct clock_event pit_event = {
+    .name = "PIT",
+    .max_cycles = pit_max_cycles,
+    .program = pit_program,
+    .stop = pit_stop
+};
+
+void pit_set_oneshot(uint16_t count)
+{
+    if (count == 0)
+    {
+        // zero is taken as 65536 by the PIT
+        count = 1;
+    }
+
+    outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL0_ONESHOT);
+    outb(PIT_CHANNEL0_DATA_PORT, count & 0xff);
+    outb(PIT_CHANNEL0_DATA_PORT, (count >> 8) & 0xff);
+}
+
+void pit_stop()
+{
+    // In mode 0 the counter does not start until a count is written
+    outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL0_ONESHOT);
+}
+
+/** @brief the 16 bit counter can not wait longer than ~55ms */
+static uint64_t pit_max_cycles()
+{
+    return (uint64_t) clock_tsc_khz() * (PIT_MAX_COUNT / (PIT_FREQUENCY / 1000));
+}
+
+static void pit_program(uint64_t cycles)
+{
+    uint64_t count = div64(cycles * (PIT_FREQUENCY / 1000), clock_tsc_khz());
+    if (count > PIT_MAX_COUNT)
+    {
+        count = PIT_MAX_COUNT;
+    }
+
+    pit_set_oneshot((uint16_t) count);
+}
+
+struct clock_event* pit_clock_event()
+{
+    return &pit_event;
+}
+
+void pit_channel2_start(uint16_t count)
+{
+    // Gate low and speaker off while the channel is programmed
+    unsigned char port_b = insb(PIT_CHANNEL2_GATE_PORT) & ~(PIT_CHANNEL2_GATE | PIT_CHANNEL2_SPEAKER);
+    outb(PIT_CHANNEL2_GATE_PORT, port_b);
+
+    outb(PIT_COMMAND_PORT, PIT_COMMAND_CHANNEL2_ONESHOT);
+    outb(PIT_CHANNEL2_DATA_PORT, count & 0xff);
+    outb(PIT_CHANNEL2_DATA_PORT, (count >> 8) & 0xff);
+
+    // Rising edge of the gate starts the count down
+    outb(PIT_CHANNEL2_GATE_PORT, port_b | PIT_CHANNEL2_GATE);
+}
+
+bool pit_channel2_expired()
+{
+    return (insb(PIT_CHANNEL2_GATE_PORT) & PIT_CHANNEL2_OUT) != 0;
+}
@@ -0,0 +1,60 @@
+#ifndef PIT_H
+#define PIT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "timer.h"
+
+/** @file pit.h
+ * @brief The Programmable Interval Timer (Intel 8253/8254) generates the timer interrupt (IRQ0).
+ * Its oscillator runs at ~1.193182 MHz and a channel counts it down from a programmed value.
+ * See https://wiki.osdev.org/Programmable_Interval_Timer
+*/
+
+/** @brief frequency of the PIT oscillator in Hz */
+#define PIT_FREQUENCY 1193182
+
+/** @brief Channel 0 data port, it is connected to IRQ0 */
+#define PIT_CHANNEL0_DATA_PORT 0x40
+
+/** @brief Channel 2 data port, it is connected to the PC speaker, we only use it to measure time */
+#define PIT_CHANNEL2_DATA_PORT 0x42
+
+/** @brief Mode/Command register (write only) */
+#define PIT_COMMAND_PORT 0x43
+
+/** @brief Channel 0, access mode lobyte/hibyte, mode 0 (interrupt on terminal count), binary mode */
+#define PIT_COMMAND_CHANNEL0_ONESHOT 0x30
+
+/** @brief Channel 2, access mode lobyte/hibyte, mode 0 (interrupt on terminal count), binary mode */
+#define PIT_COMMAND_CHANNEL2_ONESHOT 0xB0
+
+/** @brief keyboard controller port B which holds the gate and the output of channel 2 */
+#define PIT_CHANNEL2_GATE_PORT 0x61
+/** @brief channel 2 counts while its gate is high */
+#define PIT_CHANNEL2_GATE 0x01
+/** @brief connects the channel 2 output to the speaker, we keep it off */
+#define PIT_CHANNEL2_SPEAKER 0x02
+/** @brief the output of channel 2, it goes high when the count reaches zero */
+#define PIT_CHANNEL2_OUT 0x20
+
+/** @brief biggest value a 16 bit counter can count down from */
+#define PIT_MAX_COUNT 0xFFFF
+
+/** @brief fire the timer interrupt once after 'count' PIT cycles */
+void pit_set_oneshot(uint16_t count);
+
+/** @brief stop channel 0, no timer interrupt is fired until it is programmed again */
+void pit_stop();
+
+/** @brief channel 0 as the device raising the timer interrupt (IRQ 0) */
+struct clock_event* pit_clock_event();
+
+/** @brief start counting down 'count' PIT cycles on channel 2 without raising an interrupt */
+void pit_channel2_start(uint16_t count);
+
+/** @brief check whether the count started by pit_channel2_start reached zero */
+bool pit_channel2_expired();
+
+#endif
@@ -0,0 +1,293 @@
+#include "timer.h"
+#include "pit.h"
+#include "clock.h"
+#include "config.h"
+#include "memory/memory.h"
+
+/** @brief root wheel, slot index is the lowest bits of the tick a timer expires at */
+static struct timer* timer_root_wheel[TIMER_WHEEL_ROOT_SIZE];
+
+/** @brief coarser wheels, each slot covers the whole range of the wheel below it */
+static struct timer* timer_wheels[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+
+/** @brief the next tick the wheel has to process, it lags behind the clocksource
+ * until timer_tick catches up */
+static uint32_t timer_wheel_jiffies = 1;
+
+/** @brief number of armed timers */
+static uint32_t timer_pending_count = 0;
+
+/** @brief the device raising the timer interrupt */
+static struct clock_event* timer_clock_event = 0;
+
+void timer_init()
+{
+    memset(timer_root_wheel, 0, sizeof(timer_root_wheel));
+    memset(timer_wheels, 0, sizeof(timer_wheels));
+    timer_pending_count = 0;
+
+    clock_init();
+    timer_wheel_jiffies = clock_ticks() + 1;
+
+    // The timer interrupt is only programmed when something waits for it
+    timer_set_clock_event(pit_clock_event());
+}
+
+void timer_set_clock_event(struct clock_event* event)
+{
+    if (timer_clock_event)
+    {
+        timer_clock_event->stop();
+    }
+
+    timer_clock_event = event;
+    timer_clock_event->stop();
+}
+
+uint32_t timer_ticks()
+{
+    return clock_ticks();
+}
+
+uint32_t timer_ms_to_ticks(uint32_t ms)
+{
+    // Whole seconds and the rest apart, ms * MAEROS_TIMER_HZ would overflow for long timeouts
+    return ms / 1000 * MAEROS_TIMER_HZ + ((ms % 1000) * MAEROS_TIMER_HZ + 999) / 1000;
+}
+
+void timer_setup(struct timer* timer, TIMER_CALLBACK_FUNCTION callback, void* data)
+{
+    memset(timer, 0, sizeof(struct timer));
+    timer->callback = callback;
+    timer->data = data;
+}
+
+bool timer_pending(struct timer* timer)
+{
+    return timer->slot != 0;
+}
+
+/** @brief index of the slot of a coarser wheel for the given tick */
+static uint32_t timer_wheel_index(uint32_t tick, int level)
+{
+    return (tick >> (TIMER_WHEEL_ROOT_BITS + level * TIMER_WHEEL_BITS)) & TIMER_WHEEL_MASK;
+}
+
+/** @brief find the slot for the timer according to how far it expires and link it */
+static void timer_insert(struct timer* timer)
+{
+    uint32_t expires = timer->expires;
+    uint32_t delta = expires - timer_wheel_jiffies;
+    struct timer** slot = 0;
+
+    if ((int32_t) delta < 0)
+    {
+        // Already expired, it runs on the next tick processed
+        slot = &timer_root_wheel[timer_wheel_jiffies & TIMER_WHEEL_ROOT_MASK];
+    }
+    else if (delta < TIMER_WHEEL_ROOT_SIZE)
+    {
+        slot = &timer_root_wheel[expires & TIMER_WHEEL_ROOT_MASK];
+    }
+    else
+    {
+        int level = 0;
+        while(level < TIMER_WHEEL_LEVELS - 1 &&
+                delta >= (1U << (TIMER_WHEEL_ROOT_BITS + (level + 1) * TIMER_WHEEL_BITS)))
+        {
+            level++;
+        }
+
+        slot = &timer_wheels[level][timer_wheel_index(expires, level)];
+    }
+
+    timer->slot = slot;
+    timer->prev = 0;
+    timer->next = *slot;
+    if (*slot)
+    {
+        (*slot)->prev = timer;
+    }
+    *slot = timer;
+}
+
+/** @brief unlink the timer from its slot */
+static void timer_detach(struct timer* timer)
+{
+    if (timer->prev)
+    {
+        timer->prev->next = timer->next;
+    }
+    else
+    {
+        *timer->slot = timer->next;
+    }
+
+    if (timer->next)
+    {
+        timer->next->prev = timer->prev;
+    }
+
+    timer->slot = 0;
+    timer->next = 0;
+    timer->prev = 0;
+    timer_pending_count--;
+}
+
+static void timer_advance();
+
+void timer_add(struct timer* timer, uint32_t expires)
+{
+    if (timer_pending(timer))
+    {
+        timer_detach(timer);
+    }
+
+    // The wheel is used as the reference point, so bring it up to date first
+    timer_advance();
+
+    timer->expires = expires;
+    timer_insert(timer);
+    timer_pending_count++;
+}
+
+void timer_cancel(struct timer* timer)
+{
+    if (timer_pending(timer))
+    {
+        timer_detach(timer);
+    }
+}
+
+/** @brief move every timer in the slot of a coarser wheel one level down
+ * @retval the index of the slot, zero means the wheel wrapped around as well
+*/
+static uint32_t timer_cascade(int level, uint32_t index)
+{
+    struct timer* timer = timer_wheels[level][index];
+    timer_wheels[level][index] = 0;
+
+    while(timer)
+    {
+        struct timer* next = timer->next;
+        timer->slot = 0;
+        timer_insert(timer);
+        timer = next;
+    }
+
+    return index;
+}
+
+/** @brief process a single tick of the wheel, expired timers are run */
+static void timer_run_wheel_tick()
+{
+    uint32_t index = timer_wheel_jiffies & TIMER_WHEEL_ROOT_MASK;
+    if (index == 0)
+    {
+        // root wheel wrapped around, bring the timers of the next range down
+        int level = 0;
+        while(level < TIMER_WHEEL_LEVELS &&
+                timer_cascade(level, timer_wheel_index(timer_wheel_jiffies, level)) == 0)
+        {
+            level++;
+        }
+    }
+
+    timer_wheel_jiffies++;
+
+    /* expired timers are moved to a local list so that a callback can still
+    cancel (or rearm) any of them safely */
+    struct timer* expired = timer_root_wheel[index];
+    timer_root_wheel[index] = 0;
+    for (struct timer* timer = expired; timer; timer = timer->next)
+    {
+        timer->slot = &expired;
+    }
+
+    while(expired)
+    {
+        struct timer* timer = expired;
+        timer_detach(timer);
+        timer->callback(timer);
+    }
+}
+
+/** @brief process every tick of the wheel up to the current time of the clocksource */
+static void timer_advance()
+{
+    uint32_t now = clock_ticks();
+    while((int32_t)(now - timer_wheel_jiffies) >= 0)
+    {
+        if (timer_pending_count == 0)
+        {
+            // Wheel is empty, there is nothing to run in the ticks we skip
+            timer_wheel_jiffies = now + 1;
+            break;
+        }
+
+        timer_run_wheel_tick();
+    }
+}
+
+void timer_tick()
+{
+    timer_advance();
+}
+
+/** @brief find the tick at which the wheel has work to do next
+ * @note for the coarser wheels it is the tick the root wheel wraps around and they are cascaded
+*/
+static bool timer_next_expiry(uint32_t* tick_out)
+{
+    if (timer_pending_count == 0)
+    {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < TIMER_WHEEL_ROOT_SIZE; i++)
+    {
+        uint32_t tick = timer_wheel_jiffies + i;
+        if (timer_root_wheel[tick & TIMER_WHEEL_ROOT_MASK])
+        {
+            *tick_out = tick;
+            return true;
+        }
+
+        if (((tick + 1) & TIMER_WHEEL_ROOT_MASK) == 0)
+        {
+            *tick_out = tick + 1;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void timer_program_next_event(bool has_deadline, uint32_t deadline)
+{
+    uint32_t next = 0;
+    bool has_next = timer_next_expiry(&next);
+    if (has_deadline && (!has_next || (int32_t)(deadline - next) < 0))
+    {
+        next = deadline;
+        has_next = true;
+    }
+
+    if (!has_next)
+    {
+        // Nothing to wait for, no more timer interrupts (tickless)
+        timer_clock_event->stop();
+        return;
+    }
+
+    /* the device may not count as far as the event (i.e. ~55ms for the PIT), for a later
+    event we are interrupted earlier and the timer is programmed again */
+    uint64_t cycles = clock_cycles_until(next);
+    uint64_t max_cycles = timer_clock_event->max_cycles();
+    if (cycles > max_cycles)
+    {
+        cycles = max_cycles;
+    }
+
+    timer_clock_event->program(cycles);
+}
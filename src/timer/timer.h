@@ -0,0 +1,103 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @file timer.h
+ * @brief Kernel timers kept in a hierarchical timer wheel driven by the timer interrupt.
+ *
+ * The root wheel has a slot for each of the next 256 ticks. Timers further away are kept
+ * in coarser wheels of 64 slots each, and a slot of a coarser wheel is moved (cascaded)
+ * down to the finer wheel when the finer wheel wraps around. Adding and cancelling a timer
+ * is just linking/unlinking it to/from a slot list, so both are O(1).
+ *
+ * The timer interrupt is not periodic. The time is read from the clocksource (see clock.h)
+ * and the interrupt is programmed in one-shot mode only for the next event. The interrupt
+ * comes from a clock event device, the PIT or the local APIC timer of the BSP.
+*/
+
+/** @brief number of bits and slots of the root (finest) wheel */
+#define TIMER_WHEEL_ROOT_BITS 8
+#define TIMER_WHEEL_ROOT_SIZE (1 << TIMER_WHEEL_ROOT_BITS)
+#define TIMER_WHEEL_ROOT_MASK (TIMER_WHEEL_ROOT_SIZE - 1)
+
+/** @brief number of bits and slots of the each coarser wheel */
+#define TIMER_WHEEL_BITS 6
+#define TIMER_WHEEL_SIZE (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SIZE - 1)
+
+/** @brief number of coarser wheels, 8 + 4 * 6 bits covers whole 32 bit tick range */
+#define TIMER_WHEEL_LEVELS 4
+
+struct timer;
+
+/** @brief a device raising the one-shot timer interrupt */
+struct clock_event
+{
+    const char* name;
+
+    /** @brief the longest wait the device can count, in TSC cycles */
+    uint64_t (*max_cycles)();
+
+    /** @brief raise the timer interrupt once after 'cycles' TSC cycles */
+    void (*program)(uint64_t cycles);
+
+    /** @brief no timer interrupt until the device is programmed again */
+    void (*stop)();
+};
+
+/** @brief function called from the timer interrupt when the timer expires */
+typedef void (*TIMER_CALLBACK_FUNCTION)(struct timer* timer);
+
+struct timer
+{
+    /** @brief the tick at which the timer expires */
+    uint32_t expires;
+
+    /** @brief called when the timer expires */
+    TIMER_CALLBACK_FUNCTION callback;
+
+    /** @brief private data of the timer owner, i.e. a task to wake up */
+    void* data;
+
+    /** @brief the wheel slot the timer is linked into, zero if it is not pending */
+    struct timer** slot;
+
+    struct timer* next;
+    struct timer* prev;
+};
+
+/** @brief calibrate the clocksource and reset the wheel, the PIT raises the timer interrupt
+ * until another clock event device is set */
+void timer_init();
+
+/** @brief raise the timer interrupt with 'event' from now on */
+void timer_set_clock_event(struct clock_event* event);
+
+/** @brief called by the timer interrupt, it runs every expired timer */
+void timer_tick();
+
+/** @brief number of timer ticks since boot, it is read from the clocksource */
+uint32_t timer_ticks();
+
+/** @brief program the timer interrupt in one-shot mode for the next timer in the wheel,
+ * or for 'deadline' (i.e. end of a time slice) if it comes earlier.
+ * The timer interrupt is stopped when there is nothing to wait for.
+*/
+void timer_program_next_event(bool has_deadline, uint32_t deadline);
+
+/** @brief convert milliseconds to timer ticks, it rounds up */
+uint32_t timer_ms_to_ticks(uint32_t ms);
+
+void timer_setup(struct timer* timer, TIMER_CALLBACK_FUNCTION callback, void* data);
+
+/** @brief arm the timer to expire at tick 'expires', it is rearmed if it is already pending */
+void timer_add(struct timer* timer, uint32_t expires);
+
+/** @brief disarm the timer, it does nothing if the timer is not pending */
+void timer_cancel(struct timer* timer);
+
+bool timer_pending(struct timer* timer);
+
+#endif
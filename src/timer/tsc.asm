@@ -0,0 +1,12 @@
+[BITS 32]
+
+section .asm
+
+global tsc_read
+
+; uint64_t tsc_read()
+; rdtsc returns the time stamp counter in edx:eax, which is where
+; a 64 bit result is returned by the C calling convention as well
+tsc_read:
+    rdtsc
+    ret
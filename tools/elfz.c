@@ -0,0 +1,227 @@
+/** @file elfz.c
+ * @brief Host tool building an elfz container (see src/loader/formats/elfz.h) from an ELF
+ * executable. Every PT_LOAD segment is compressed as an LZ4 block, the kernel decompresses
+ * it straight into the pages of the segment while reading the file.
+ *
+ * usage: elfz <in.elf> <out.elf>
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../src/loader/formats/elf.h"
+#include "../src/loader/formats/elfz.h"
+
+/** @brief the last literals of a block, a match never covers them */
+#define LZ4_LAST_LITERALS 5
+/** @brief a match starts at least this many bytes before the end of the block */
+#define LZ4_MATCH_LIMIT 12
+#define LZ4_MIN_MATCH 4
+#define LZ4_MAX_OFFSET 65535
+#define LZ4_HASH_BITS 12
+
+static const char elf_signature[] = {0x7f, 'E', 'L', 'F'};
+
+static uint32_t lz4_read32(const uint8_t* p)
+{
+    uint32_t value;
+    memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+static uint32_t lz4_hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+static uint8_t* lz4_write_length(uint8_t* out, uint32_t length)
+{
+    for (; length >= 255; length -= 255)
+    {
+        *out++ = 255;
+    }
+    *out++ = length;
+    return out;
+}
+
+static uint8_t* lz4_write_sequence(uint8_t* out, const uint8_t* literals, uint32_t literal_length, uint32_t offset, uint32_t match_length)
+{
+    uint8_t* token = out++;
+    *token = (literal_length >= 15 ? 15 : literal_length) << 4;
+    if (literal_length >= 15)
+    {
+        out = lz4_write_length(out, literal_length - 15);
+    }
+
+    memcpy(out, literals, literal_length);
+    out += literal_length;
+
+    // The last sequence has literals only
+    if (match_length == 0)
+    {
+        return out;
+    }
+
+    *out++ = offset & 0xff;
+    *out++ = offset >> 8;
+
+    match_length -= LZ4_MIN_MATCH;
+    *token |= match_length >= 15 ? 15 : match_length;
+    if (match_length >= 15)
+    {
+        out = lz4_write_length(out, match_length - 15);
+    }
+
+    return out;
+}
+
+/** @brief the most bytes the block of 'size' bytes is compressed to */
+static uint32_t lz4_bound(uint32_t size)
+{
+    return size + size / 255 + 16;
+}
+
+/** @brief compress 'size' bytes of 'in' into an LZ4 block, greedily taking the match the
+ * hash of the next four bytes points to
+ * @retval size of the block
+*/
+static uint32_t lz4_compress(const uint8_t* in, uint32_t size, uint8_t* out)
+{
+    static uint32_t table[1 << LZ4_HASH_BITS];
+    uint8_t* start = out;
+    uint32_t anchor = 0;
+    uint32_t pos = 0;
+
+    memset(table, 0xff, sizeof(table));
+    while (size > LZ4_MATCH_LIMIT && pos <= size - LZ4_MATCH_LIMIT)
+    {
+        uint32_t sequence = lz4_read32(in + pos);
+        uint32_t hash = lz4_hash(sequence);
+        uint32_t candidate = table[hash];
+        table[hash] = pos;
+
+        if (candidate == 0xffffffff || pos - candidate > LZ4_MAX_OFFSET || lz4_read32(in + candidate) != sequence)
+        {
+            pos++;
+            continue;
+        }
+
+        uint32_t length = LZ4_MIN_MATCH;
+        while (pos + length < size - LZ4_LAST_LITERALS && in[candidate + length] == in[pos + length])
+        {
+            length++;
+        }
+
+        out = lz4_write_sequence(out, in + anchor, pos - anchor, pos - candidate, length);
+        pos += length;
+        anchor = pos;
+    }
+
+    out = lz4_write_sequence(out, in + anchor, size - anchor, 0, 0);
+    return out - start;
+}
+
+static uint8_t* read_file(const char* filename, uint32_t* size)
+{
+    FILE* file = fopen(filename, "rb");
+    if (!file)
+    {
+        return 0;
+    }
+
+    fseek(file, 0, SEEK_END);
+    *size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    uint8_t* data = malloc(*size ? *size : 1);
+    if (data && fread(data, 1, *size, file) != *size)
+    {
+        free(data);
+        data = 0;
+    }
+
+    fclose(file);
+    return data;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <in.elf> <out.elf>\n", argv[0]);
+        return 1;
+    }
+
+    uint32_t size = 0;
+    uint8_t* elf = read_file(argv[1], &size);
+    if (!elf)
+    {
+        fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    struct elf_header* header = (struct elf_header*) elf;
+    if (size < sizeof(*header) || memcmp(header->e_ident, elf_signature, sizeof(elf_signature)) != 0 ||
+        header->e_phentsize != sizeof(struct elf32_phdr) ||
+        header->e_phoff + header->e_phnum * sizeof(struct elf32_phdr) > size)
+    {
+        fprintf(stderr, "%s: %s is not an ELF file\n", argv[0], argv[1]);
+        return 1;
+    }
+
+    struct elf32_phdr* phdrs = (struct elf32_phdr*)(elf + header->e_phoff);
+    struct elfz_segment* table = calloc(header->e_phnum ? header->e_phnum : 1, sizeof(struct elfz_segment));
+    uint32_t offset = sizeof(struct elfz_header) + sizeof(*header) +
+                      header->e_phnum * (sizeof(struct elf32_phdr) + sizeof(struct elfz_segment));
+
+    uint32_t bound = offset;
+    for (int i = 0; i < header->e_phnum; i++)
+    {
+        bound += lz4_bound(phdrs[i].p_filesz);
+    }
+
+    uint8_t* out = calloc(bound, 1);
+    for (int i = 0; i < header->e_phnum; i++)
+    {
+        struct elf32_phdr* phdr = &phdrs[i];
+        if (phdr->p_type != PT_LOAD || phdr->p_filesz == 0)
+        {
+            continue;
+        }
+
+        if (phdr->p_offset + phdr->p_filesz > size)
+        {
+            fprintf(stderr, "%s: segment %d of %s is past the end of the file\n", argv[0], i, argv[1]);
+            return 1;
+        }
+
+        table[i].offset = offset;
+        table[i].compressed_size = lz4_compress(elf + phdr->p_offset, phdr->p_filesz, out + offset);
+        offset += table[i].compressed_size;
+    }
+
+    struct elfz_header container = {
+        .magic = {ELFZ_MAGIC0, ELFZ_MAGIC1, ELFZ_MAGIC2, ELFZ_MAGIC3},
+        .version = ELFZ_VERSION,
+        .elf_size = size,
+    };
+
+    uint8_t* ptr = out;
+    memcpy(ptr, &container, sizeof(container));
+    ptr += sizeof(container);
+    memcpy(ptr, header, sizeof(*header));
+    ptr += sizeof(*header);
+    memcpy(ptr, phdrs, header->e_phnum * sizeof(struct elf32_phdr));
+    ptr += header->e_phnum * sizeof(struct elf32_phdr);
+    memcpy(ptr, table, header->e_phnum * sizeof(struct elfz_segment));
+
+    FILE* file = fopen(argv[2], "wb");
+    if (!file || fwrite(out, 1, offset, file) != offset)
+    {
+        fprintf(stderr, "%s: cannot write %s\n", argv[0], argv[2]);
+        return 1;
+    }
+    fclose(file);
+
+    printf("%s: %u -> %u bytes\n", argv[2], size, offset);
+    return 0;
+}